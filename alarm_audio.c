@@ -0,0 +1,325 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <math.h>
+#include <endian.h>
+
+#include "alarm_audio.h"
+
+#define RAW_RATE        (44100)
+#define BAND_LOW_HZ     (40.0)
+#define BAND_HIGH_HZ    (8000.0)
+#define ATTACK_SEC      (0.010)
+#define DECAY_SEC       (0.300)
+#define PEAK_DECAY_SEC  (10.0)
+#define PEAK_FLOOR      (1.0f)      // about -50 dBFS, keeps hiss from being stretched to full scale
+
+#define FFT_N           (ALARM_AUDIO_FFT_SIZE)
+#define FFT_M           (ALARM_AUDIO_FFT_SIZE / 2)
+
+static int
+read_full(
+    alarm_audio_source_t *src,
+    void *buf,
+    int len
+)
+{
+  uint8_t *p = buf;
+  int got = 0;
+
+  // sniffed header bytes go out first
+  if (src->pending_len > 0) {
+    int n = (src->pending_len < len) ? src->pending_len : len;
+    memcpy(p, src->pending, n);
+    memmove(src->pending, src->pending + n, src->pending_len - n);
+    src->pending_len -= n;
+    got += n;
+  }
+
+  while (got < len) {
+    ssize_t n = read(src->fd, p + got, len - got);
+    if (n <= 0) {
+      src->eof = true;
+      break;
+    }
+    got += n;
+  }
+
+  return got;
+}
+
+static uint32_t
+le32(
+    const uint8_t *p
+)
+{
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t
+le16(
+    const uint8_t *p
+)
+{
+  return p[0] | (p[1] << 8);
+}
+
+static int
+parse_wav(
+    alarm_audio_source_t *src
+)
+{
+  // walk the chunks after RIFF/WAVE until "data", picking up "fmt " on the way
+  bool have_fmt = false;
+  uint8_t hdr[8];
+  while (8 == read_full(src, hdr, 8)) {
+    uint32_t len = le32(hdr + 4);
+    if (0 == memcmp(hdr, "data", 4))
+      return have_fmt ? 0 : -1;
+
+    if (0 == memcmp(hdr, "fmt ", 4) && len >= 16) {
+      uint8_t fmt[16];
+      if (16 != read_full(src, fmt, 16))
+        return -1;
+      len -= 16;
+      if (le16(fmt + 0) != 1 || le16(fmt + 14) != 16)
+        return -1;
+      src->channels = le16(fmt + 2);
+      src->rate     = le32(fmt + 4);
+      if (src->channels < 1 || src->channels > ALARM_AUDIO_MAX_CHANS || src->rate <= 0)
+        return -1;
+      have_fmt = true;
+    }
+
+    // skip the rest of the chunk, including the pad byte of odd lengths
+    uint8_t skip[64];
+    len += len & 1;
+    while (len > 0) {
+      int n = (len < sizeof(skip)) ? len : sizeof(skip);
+      if (n != read_full(src, skip, n))
+        return -1;
+      len -= n;
+    }
+  }
+
+  return -1;
+}
+
+int
+alarm_audio_open(
+    alarm_audio_source_t *src,
+    const char *path
+)
+{
+  memset(src, 0, sizeof(*src));
+  src->rate     = RAW_RATE;
+  src->channels = 1;
+
+  src->fd = (0 == strcmp(path, "-")) ? STDIN_FILENO : open(path, O_RDONLY);
+  if (src->fd < 0)
+    return -1;
+
+  uint8_t riff[12];
+  int n = read_full(src, riff, sizeof(riff));
+  if (n == 12 && 0 == memcmp(riff, "RIFF", 4) && 0 == memcmp(riff + 8, "WAVE", 4)) {
+    if (parse_wav(src)) {
+      alarm_audio_close(src);
+      return -1;
+    }
+  } else {
+    // headerless -- those bytes were already samples
+    memcpy(src->pending, riff, n);
+    src->pending_len = n;
+    src->eof = false;
+  }
+
+  return 0;
+}
+
+void
+alarm_audio_close(
+    alarm_audio_source_t *src
+)
+{
+  if (src->fd > STDIN_FILENO)
+    close(src->fd);
+  src->fd = -1;
+}
+
+int
+alarm_audio_read(
+    alarm_audio_source_t *src,
+    float *mono,
+    int count
+)
+{
+  if (count > ALARM_AUDIO_HOP)
+    count = ALARM_AUDIO_HOP;
+
+  int chans = src->channels;
+  int bytes = read_full(src, src->raw, count * chans * sizeof(int16_t));
+  int frames = bytes / (chans * sizeof(int16_t));
+
+  float scale = 1.0f / (32768.0f * chans);
+  int ii, cc;
+  for (ii=0; ii<frames; ii++) {
+    int32_t sum = 0;
+    for (cc=0; cc<chans; cc++)
+      sum += (int16_t)le16toh(src->raw[ii * chans + cc]);
+    mono[ii] = sum * scale;
+  }
+
+  return frames;
+}
+
+void
+alarm_audio_analyzer_init(
+    alarm_audio_analyzer_t *an,
+    int rate
+)
+{
+  memset(an, 0, sizeof(*an));
+
+  int ii;
+  for (ii=0; ii<FFT_N; ii++)
+    an->window[ii] = 0.5f - 0.5f * cosf(2.0f * M_PI * ii / FFT_N);
+
+  // e^(-2 pi i k / N); the half-size complex FFT uses every other entry
+  for (ii=0; ii<FFT_M; ii++) {
+    an->tw_re[ii] =  cosf(2.0f * M_PI * ii / FFT_N);
+    an->tw_im[ii] = -sinf(2.0f * M_PI * ii / FFT_N);
+  }
+
+  int bits = 0;
+  while ((1 << bits) < FFT_M)
+    bits++;
+  for (ii=0; ii<FFT_M; ii++) {
+    int rev = 0, bb;
+    for (bb=0; bb<bits; bb++)
+      rev |= ((ii >> bb) & 1) << (bits - 1 - bb);
+    an->bitrev[ii] = rev;
+  }
+
+  // log-spaced bands, at least one bin each and never sharing a bin with the band below;
+  //   bands above Nyquist come out empty
+  double hz_per_bin = (double)rate / FFT_N;
+  int bb, prev_hi = 1;
+  for (bb=0; bb<ALARM_AUDIO_BANDS; bb++) {
+    double lo = BAND_LOW_HZ * pow(BAND_HIGH_HZ / BAND_LOW_HZ, (double)bb / ALARM_AUDIO_BANDS);
+    double hi = BAND_LOW_HZ * pow(BAND_HIGH_HZ / BAND_LOW_HZ, (double)(bb + 1) / ALARM_AUDIO_BANDS);
+    int lo_bin = (int)(lo / hz_per_bin);
+    int hi_bin = (int)(hi / hz_per_bin);
+    if (lo_bin < prev_hi)
+      lo_bin = prev_hi;
+    if (hi_bin <= lo_bin)
+      hi_bin = lo_bin + 1;
+    if (lo_bin > FFT_M)
+      lo_bin = FFT_M;
+    if (hi_bin > FFT_M)
+      hi_bin = FFT_M;
+    an->band_lo[bb] = lo_bin;
+    an->band_hi[bb] = hi_bin;
+    prev_hi = hi_bin;
+  }
+
+  // one-pole coefficients per hop
+  double hop_sec = (double)ALARM_AUDIO_HOP / rate;
+  an->attack     = 1.0 - exp(-hop_sec / ATTACK_SEC);
+  an->decay      = 1.0 - exp(-hop_sec / DECAY_SEC);
+  an->peak_decay = exp(-hop_sec / PEAK_DECAY_SEC);
+  for (bb=0; bb<ALARM_AUDIO_BANDS; bb++)
+    an->peak[bb] = PEAK_FLOOR;
+}
+
+static void
+fft_half(
+    alarm_audio_analyzer_t *an
+)
+{
+  // in-place radix-2 over split re/im arrays; inner loops are unit-stride float math
+  float *re = an->re, *im = an->im;
+  int len, ii, jj;
+
+  for (ii=0; ii<FFT_M; ii++) {
+    jj = an->bitrev[ii];
+    if (jj > ii) {
+      float t;
+      t = re[ii]; re[ii] = re[jj]; re[jj] = t;
+      t = im[ii]; im[ii] = im[jj]; im[jj] = t;
+    }
+  }
+
+  for (len=2; len<=FFT_M; len<<=1) {
+    int half = len >> 1;
+    int step = 2 * FFT_M / len;
+    for (ii=0; ii<FFT_M; ii+=len) {
+      for (jj=0; jj<half; jj++) {
+        float wr = an->tw_re[jj * step];
+        float wi = an->tw_im[jj * step];
+        int a = ii + jj, b = a + half;
+        float xr = re[b] * wr - im[b] * wi;
+        float xi = re[b] * wi + im[b] * wr;
+        re[b] = re[a] - xr;
+        im[b] = im[a] - xi;
+        re[a] += xr;
+        im[a] += xi;
+      }
+    }
+  }
+}
+
+void
+alarm_audio_analyze(
+    alarm_audio_analyzer_t *an,
+    const float *hop
+)
+{
+  int ii, bb;
+
+  // slide the block along by one hop
+  memmove(an->history, an->history + ALARM_AUDIO_HOP, (FFT_N - ALARM_AUDIO_HOP) * sizeof(float));
+  memcpy(an->history + FFT_N - ALARM_AUDIO_HOP, hop, ALARM_AUDIO_HOP * sizeof(float));
+
+  // pack even/odd real samples as one half-size complex sequence
+  for (ii=0; ii<FFT_M; ii++) {
+    an->re[ii] = an->history[2 * ii]     * an->window[2 * ii];
+    an->im[ii] = an->history[2 * ii + 1] * an->window[2 * ii + 1];
+  }
+  fft_half(an);
+
+  // untangle into the N/2 + 1 bins of the real spectrum
+  an->power[0]     = (an->re[0] + an->im[0]) * (an->re[0] + an->im[0]);
+  an->power[FFT_M] = (an->re[0] - an->im[0]) * (an->re[0] - an->im[0]);
+  for (ii=1; ii<FFT_M; ii++) {
+    float ar = an->re[ii],         ai = an->im[ii];
+    float br = an->re[FFT_M - ii], bi = -an->im[FFT_M - ii];
+    float er = 0.5f * (ar + br),   ei = 0.5f * (ai + bi);
+    float dr = 0.5f * (ai - bi),   di = -0.5f * (ar - br);
+    float wr = an->tw_re[ii],      wi = an->tw_im[ii];
+    float xr = er + dr * wr - di * wi;
+    float xi = ei + dr * wi + di * wr;
+    an->power[ii] = xr * xr + xi * xi;
+  }
+
+  for (bb=0; bb<ALARM_AUDIO_BANDS; bb++) {
+    float e = 0;
+    for (ii=an->band_lo[bb]; ii<an->band_hi[bb]; ii++)
+      e += an->power[ii];
+    if (an->band_hi[bb] > an->band_lo[bb])
+      e = sqrtf(e / (an->band_hi[bb] - an->band_lo[bb]));
+
+    an->env[bb] += ((e > an->env[bb]) ? an->attack : an->decay) * (e - an->env[bb]);
+
+    an->peak[bb] *= an->peak_decay;
+    if (an->env[bb] > an->peak[bb])
+      an->peak[bb] = an->env[bb];
+    if (an->peak[bb] < PEAK_FLOOR)
+      an->peak[bb] = PEAK_FLOOR;
+
+    an->level[bb] = an->env[bb] / an->peak[bb];
+  }
+}
@@ -0,0 +1,75 @@
+#ifndef __ALARM_AUDIO_H__
+#define __ALARM_AUDIO_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define ALARM_AUDIO_FFT_SIZE    (1024)
+#define ALARM_AUDIO_HOP         (ALARM_AUDIO_FFT_SIZE / 2)
+#define ALARM_AUDIO_BANDS       (8)
+#define ALARM_AUDIO_MAX_CHANS   (8)
+
+// 16-bit PCM from a WAV file, or raw S16_LE mono at 44.1 kHz from a pipe ("-" is stdin)
+typedef struct alarm_audio_source {
+  int      fd;
+  int      rate;
+  int      channels;
+  bool     eof;
+  int      pending_len;        // bytes sniffed while looking for a WAV header
+  uint8_t  pending[12];
+  int16_t  raw[ALARM_AUDIO_HOP * ALARM_AUDIO_MAX_CHANS];
+} alarm_audio_source_t;
+
+// windowed real FFT over 50% overlapping blocks, reduced to smoothed band levels
+typedef struct alarm_audio_analyzer {
+  float    window[ALARM_AUDIO_FFT_SIZE];
+  float    history[ALARM_AUDIO_FFT_SIZE];
+  float    re[ALARM_AUDIO_FFT_SIZE / 2];
+  float    im[ALARM_AUDIO_FFT_SIZE / 2];
+  float    tw_re[ALARM_AUDIO_FFT_SIZE / 2];
+  float    tw_im[ALARM_AUDIO_FFT_SIZE / 2];
+  uint16_t bitrev[ALARM_AUDIO_FFT_SIZE / 2];
+  float    power[ALARM_AUDIO_FFT_SIZE / 2 + 1];
+  int      band_lo[ALARM_AUDIO_BANDS];
+  int      band_hi[ALARM_AUDIO_BANDS];
+  float    attack;
+  float    decay;
+  float    peak_decay;
+  float    env[ALARM_AUDIO_BANDS];
+  float    peak[ALARM_AUDIO_BANDS];
+  float    level[ALARM_AUDIO_BANDS];  // 0..1, relative to each band's recent peak
+} alarm_audio_analyzer_t;
+
+extern int
+alarm_audio_open(
+    alarm_audio_source_t *src,
+    const char *path
+);
+
+extern void
+alarm_audio_close(
+    alarm_audio_source_t *src
+);
+
+// read up to count frames, downmixed to mono in -1..1; returns frames read
+extern int
+alarm_audio_read(
+    alarm_audio_source_t *src,
+    float *mono,
+    int count
+);
+
+extern void
+alarm_audio_analyzer_init(
+    alarm_audio_analyzer_t *an,
+    int rate
+);
+
+// push one hop of new samples and update the band levels
+extern void
+alarm_audio_analyze(
+    alarm_audio_analyzer_t *an,
+    const float *hop
+);
+
+#endif //__ALARM_AUDIO_H__
@@ -3,6 +3,7 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 #include <signal.h>
 #include <unistd.h>
 #include <math.h>
@@ -10,11 +11,37 @@
 
 #include "ws2811.h"
 #include "color_temp.h"
+#include "alarm_light.h"
+#include "alarm_sync.h"
+#include "alarm_audio.h"
+#include "alarm_spi.h"
 
 #define WIDTH       (120)
 #define HEIGHT      (1)
 #define LED_COUNT   (WIDTH * HEIGHT)
-#define FPS         (16)
+#define FPS_MIN     (2)
+#define FPS_MAX     (60)
+
+// audio mode sweeps from warm (bass heavy) to cool (treble heavy)
+#define AUDIO_KELVIN_LOW  (1800)
+#define AUDIO_KELVIN_HIGH (6500)
+
+// a brightness swing this many 8-bit codes deep or more runs at the top frame rate
+#define FLICKER_CODES (16.0)
+
+// rand_kelvin's per-pixel grain is a constant texture, not motion -- once visible it is
+//   refreshed at this rate and no faster
+#define GRAIN_FPS     (6.0)
+
+// limiter drops immediately and recovers with this time constant, whatever the frame rate;
+//   tests build with a shorter one
+#ifndef POWER_RELEASE_SEC
+#define POWER_RELEASE_SEC (1.0)
+#endif
+#define MAX_ZONES   (8)
+
+// fill kernels run in fixed-size blocks, so gcc vectorizes them for any zone layout
+#define COLOR_BLOCK (8)
 
 #define LOG2_255p5  (7.997179481)
 #define LOG2_511p5  (8.998590430)
@@ -39,27 +66,412 @@ static ws2811_t ledstring = {
   },
 };
 static bool running = false;
+static double fps_min = FPS_MIN;
+static double fps_max = FPS_MAX;
 
-int
-alarm_light_set_mono_rgbw(
+// SPI output instead of the PWM/DMA driver when spi_device is set
+static const char  *spi_device = NULL;
+static int          spi_bits   = 3;
+static alarm_spi_t  spi;
+static ws2811_led_t spi_leds[LED_COUNT];
+
+static int         sync_role  = ALARM_LIGHT_SYNC_OFF;
+static const char *sync_group = ALARM_SYNC_GROUP;
+static int         sync_port  = ALARM_SYNC_PORT;
+
+typedef struct wakeup_profile {
+  double seconds;
+  double bright_start;
+  double bright_perSec;
+  double kelvin_start;
+  double kelvin_perSec;
+} wakeup_profile_t;
+
+typedef struct wakeup_state {
+  double max_bright;
+  double min_bright;
+  double white;
+  double kelvin;
+} wakeup_state_t;
+
+// staging frame -- everything is drawn here and handed to the driver in one render
+static ws2811_led_t frame[LED_COUNT];
+static uint16_t     frame_level = 0xffff;  // strip brightness, fused with the per-LED intensity
+static bool         in_frame = false;
+
+// per-LED intensity, 0xffff is full; flat means every entry is full and the plane is skipped
+static uint16_t     intensity[LED_COUNT];
+static bool         intensity_flat = true;
+
+// power model: mA drawn per LED by each channel at full scale, plus quiescent draw
+static struct {
+  double ma_red;
+  double ma_green;
+  double ma_blue;
+  double ma_white;
+  double ma_idle;
+  double budget;               // mA for the whole strip, 0 disables limiting
+  int    zones;                // budget is shared max-min fair across this many zones
+  double scale[MAX_ZONES];     // smoothed limiter output per zone
+  double target[MAX_ZONES];    // last frame's allocation, what the release eases toward
+  struct timespec last;        // previous render, for the release time constant
+  double current;              // estimated mA of the last rendered frame
+} power = {
+  .ma_red   = 12.0,
+  .ma_green = 12.0,
+  .ma_blue  = 12.0,
+  .ma_white = 18.0,
+  .ma_idle  =  1.0,
+  .budget   =  0.0,
+  .zones    =  1,
+  .scale    = { 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0 },
+  .target   = { 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0 },
+  .current  =  0.0,
+};
+
+// color management: optional RGB->RGBW extraction and per-channel gain, all as byte LUTs
+static struct {
+  bool    extract;             // move the common RGB component onto the white LED
+  double  white_kelvin;        // CCT of the strip's white LED
+  double  white_level;         // white LED output relative to full RGB at that CCT
+  double  gain_val[4];         // r, g, b, w
+  uint8_t to_w[3][256];        // channel value -> white units it can supply
+  uint8_t from_w[3][256];      // white units -> channel value they replace
+  uint8_t gain[4][256];
+  // fill kernel: [0] full, [1] uniform level, [2] per-LED; adds the byte sums of what it wrote
+  void  (*kernel[3])(ws2811_led_t *out, int start, int end, uint32_t level, uint32_t sums[4]);
+} pipeline = {
+  .extract      = false,
+  .white_kelvin = 4500,
+  .white_level  = 1.0,
+  .gain_val     = { 1.0, 1.0, 1.0, 1.0 },
+};
+
+static inline uint32_t
+to_code(
+  double value
+)
+{
+  // out-of-range input would spill into the next channel; NaN lands on 0
+  value = (value > 0) ? ((value < 1.0) ? value : 1.0) : 0;
+  return (uint32_t)(255.0 * value);
+}
+
+static inline ws2811_led_t
+pack_rgbw(
   double red,
   double green,
   double blue,
-  double white,
-  double bright
+  double white
 )
 {
-  // synthesize colors & brightness
-  uint32_t c_white = (uint32_t)(255.0 * white) << 24;
-  uint32_t c_red   = (uint32_t)(255.0 * red  ) << 16;
-  uint32_t c_green = (uint32_t)(255.0 * green) <<  8;
-  uint32_t c_blue  = (uint32_t)(255.0 * blue ) <<  0;
-  uint32_t composite = c_white | c_red | c_green | c_blue;
+  uint32_t c_white = to_code(white) << 24;
+  uint32_t c_red   = to_code(red  ) << 16;
+  uint32_t c_green = to_code(green) <<  8;
+  uint32_t c_blue  = to_code(blue ) <<  0;
+  return c_white | c_red | c_green | c_blue;
+}
 
+static inline bool
+range_ok(
+  int start,
+  int count
+)
+{
+  return (start >= 0) && (count >= 0) && (start <= LED_COUNT - count);
+}
+
+static void
+fill_frame(
+  int start,
+  int count,
+  ws2811_led_t composite
+)
+{
+  // plain store loop -- gcc turns this into vector stores at -O2
+  ws2811_led_t *dst = &frame[start];
   int ii;
-  for (ii=0; ii<LED_COUNT; ii++)
-    ledstring.channel[0].leds[ii] = composite;
-  ledstring.channel[0].brightness = (int)(255 * bright);
+  for (ii=0; ii<count; ii++)
+    dst[ii] = composite;
+}
+
+static inline ws2811_led_t
+color_pixel(
+  ws2811_led_t px,
+  uint32_t level,
+  bool rgbw,
+  bool extract,
+  bool gain,
+  bool dim
+)
+{
+  uint32_t w = (px >> 24) & 0xff;
+  uint32_t r = (px >> 16) & 0xff;
+  uint32_t g = (px >>  8) & 0xff;
+  uint32_t b = (px >>  0) & 0xff;
+
+  if (!rgbw) {
+    // no white LED -- mix the white knob into the color channels; w is a constant 0 from
+    //   here on, so the stages below drop their white lane
+    r = (r + w > 255) ? 255 : r + w;
+    g = (g + w > 255) ? 255 : g + w;
+    b = (b + w > 255) ? 255 : b + w;
+    w = 0;
+  } else if (extract) {
+    // largest amount of white LED that fits under all three channels
+    uint32_t x = pipeline.to_w[0][r];
+    x = (pipeline.to_w[1][g] < x) ? pipeline.to_w[1][g] : x;
+    x = (pipeline.to_w[2][b] < x) ? pipeline.to_w[2][b] : x;
+
+    uint32_t xr = pipeline.from_w[0][x];
+    uint32_t xg = pipeline.from_w[1][x];
+    uint32_t xb = pipeline.from_w[2][x];
+    r = (r > xr) ? r - xr : 0;
+    g = (g > xg) ? g - xg : 0;
+    b = (b > xb) ? b - xb : 0;
+    w = (w + x > 255) ? 255 : w + x;
+  }
+
+  if (gain) {
+    if (rgbw)
+      w = pipeline.gain[3][w];
+    r = pipeline.gain[0][r];
+    g = pipeline.gain[1][g];
+    b = pipeline.gain[2][b];
+  }
+
+  if (dim) {
+    // 8-bit color x 16-bit intensity, rounded back to 8 bits
+    w = (w * level + 0x8000) >> 16;
+    r = (r * level + 0x8000) >> 16;
+    g = (g * level + 0x8000) >> 16;
+    b = (b * level + 0x8000) >> 16;
+  }
+
+  return (w << 24) | (r << 16) | (g << 8) | (b << 0);
+}
+
+static inline void
+color_span(
+  ws2811_led_t *restrict out,
+  const ws2811_led_t *restrict in,
+  const uint16_t *restrict plane_in,
+  int count,
+  uint32_t level,
+  uint32_t sums[4],
+  bool rgbw,
+  bool extract,
+  bool gain,
+  bool dim,
+  bool plane
+)
+{
+  // the power estimate rides along: per-channel sums of exactly the bytes written
+  uint32_t sum_w = 0, sum_r = 0, sum_g = 0, sum_b = 0;
+  int ii;
+  for (ii=0; ii<count; ii++) {
+    ws2811_led_t px = color_pixel(in[ii],
+                                  (plane) ? ((uint32_t)plane_in[ii] * level + 0x8000) >> 16 : level,
+                                  rgbw, extract, gain, dim);
+    out[ii] = px;
+    sum_w += (px >> 24) & 0xff;
+    sum_r += (px >> 16) & 0xff;
+    sum_g += (px >>  8) & 0xff;
+    sum_b += (px >>  0) & 0xff;
+  }
+  sums[0] += sum_w;
+  sums[1] += sum_r;
+  sums[2] += sum_g;
+  sums[3] += sum_b;
+}
+
+// one buffer-fill kernel per layout/stage combination; the flags are constants, so each
+//   loop compiles to straight-line code with the unused stages removed -- without extraction
+//   or gain there are no table lookups left, and the full blocks vectorize at -O2
+#define COLOR_KERNEL(name, rgbw, extract, gain, dim, plane)                             \
+  static void                                                                            \
+  name(                                                                                  \
+    ws2811_led_t *restrict out,                                                          \
+    int start,                                                                           \
+    int end,                                                                             \
+    uint32_t level,                                                                      \
+    uint32_t sums[4]                                                                     \
+  )                                                                                      \
+  {                                                                                      \
+    int ii;                                                                              \
+    for (ii=start; ii+COLOR_BLOCK<=end; ii+=COLOR_BLOCK)                                 \
+      color_span(&out[ii], &frame[ii], &intensity[ii], COLOR_BLOCK, level, sums,         \
+                 rgbw, extract, gain, dim, plane);                                       \
+    color_span(&out[ii], &frame[ii], &intensity[ii], end - ii, level, sums,              \
+               rgbw, extract, gain, dim, plane);                                         \
+  }
+
+COLOR_KERNEL(color_rgbw,                    true,  false, false, false, false)
+COLOR_KERNEL(color_rgbw_dim,                true,  false, false, true,  false)
+COLOR_KERNEL(color_rgbw_plane,              true,  false, false, true,  true)
+COLOR_KERNEL(color_rgbw_gain,               true,  false, true,  false, false)
+COLOR_KERNEL(color_rgbw_gain_dim,           true,  false, true,  true,  false)
+COLOR_KERNEL(color_rgbw_gain_plane,         true,  false, true,  true,  true)
+COLOR_KERNEL(color_rgbw_extract,            true,  true,  false, false, false)
+COLOR_KERNEL(color_rgbw_extract_dim,        true,  true,  false, true,  false)
+COLOR_KERNEL(color_rgbw_extract_plane,      true,  true,  false, true,  true)
+COLOR_KERNEL(color_rgbw_extract_gain,       true,  true,  true,  false, false)
+COLOR_KERNEL(color_rgbw_extract_gain_dim,   true,  true,  true,  true,  false)
+COLOR_KERNEL(color_rgbw_extract_gain_plane, true,  true,  true,  true,  true)
+COLOR_KERNEL(color_rgb,                     false, false, false, false, false)
+COLOR_KERNEL(color_rgb_dim,                 false, false, false, true,  false)
+COLOR_KERNEL(color_rgb_plane,               false, false, false, true,  true)
+COLOR_KERNEL(color_rgb_gain,                false, false, true,  false, false)
+COLOR_KERNEL(color_rgb_gain_dim,            false, false, true,  true,  false)
+COLOR_KERNEL(color_rgb_gain_plane,          false, false, true,  true,  true)
+
+static inline uint32_t
+zone_level(
+  double scale
+)
+{
+  // limiter folded into the 16-bit level, so a limited frame is still rounded only once
+  return (uint32_t)(frame_level * scale + 0.5);
+}
+
+static double
+fill_zone(
+  ws2811_led_t *leds,
+  int zz,
+  double scale
+)
+{
+  int start = zz * LED_COUNT / power.zones;
+  int end   = (zz + 1) * LED_COUNT / power.zones;
+  uint32_t level = zone_level(scale);
+  uint32_t sums[4] = { 0, 0, 0, 0 };
+
+  pipeline.kernel[!intensity_flat ? 2 : (level != 0xffff) ? 1 : 0](leds, start, end, level, sums);
+
+  // estimated mA of what was just written
+  return (sums[0] * power.ma_white + sums[1] * power.ma_red +
+          sums[2] * power.ma_green + sums[3] * power.ma_blue) / 255.0;
+}
+
+static void
+fill_limited(
+  ws2811_led_t *leds
+)
+{
+  double idle[MAX_ZONES], active[MAX_ZONES], demand[MAX_ZONES], target[MAX_ZONES];
+  double idle_total = 0;
+  int zz;
+
+  // release: ease toward last frame's allocation, whatever the frame rate
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  double dt = (now.tv_sec - power.last.tv_sec) + 1e-9 * (now.tv_nsec - power.last.tv_nsec);
+  double release = 1.0 - exp(-((dt < 0) ? 0 : dt) / POWER_RELEASE_SEC);
+  power.last = now;
+
+  for (zz=0; zz<power.zones; zz++) {
+    int start = zz * LED_COUNT / power.zones;
+    int end   = (zz + 1) * LED_COUNT / power.zones;
+
+    // the exponential never arrives -- within half an 8-bit code of the goal is the goal
+    double s = power.scale[zz] + release * (power.target[zz] - power.scale[zz]);
+    if (power.target[zz] - s < 0.5 / 255.0)
+      s = power.target[zz];
+    power.scale[zz] = s;
+
+    idle[zz]   = power.ma_idle * (end - start);
+    active[zz] = fill_zone(leds, zz, s);
+    demand[zz] = (s > 0) ? active[zz] / s : 0;
+    target[zz] = 1.0;
+    idle_total += idle[zz];
+  }
+
+  // share what the idle draw leaves of the whole budget: zones under an even split of the
+  //   remainder keep full scale and hand back their unused share, the rest split what is left
+  if (power.budget > 0) {
+    double avail = power.budget - idle_total;
+    bool capped[MAX_ZONES] = { false };
+    int open = power.zones;
+    bool settled = false;
+    while (!settled && open > 0) {
+      double share = (avail > 0) ? avail / open : 0;
+      settled = true;
+      for (zz=0; zz<power.zones; zz++) {
+        if (!capped[zz] && demand[zz] <= share) {
+          capped[zz] = true;
+          avail -= demand[zz];
+          open--;
+          settled = false;
+        }
+      }
+      if (settled) {
+        for (zz=0; zz<power.zones; zz++)
+          if (!capped[zz])
+            target[zz] = share / demand[zz];
+      }
+    }
+  }
+
+  // attack: a zone over its share is refilled from the staging frame at once, but only if
+  //   the lower scale actually changes its level
+  power.current = 0;
+  for (zz=0; zz<power.zones; zz++) {
+    power.target[zz] = target[zz];
+    if (target[zz] < power.scale[zz]) {
+      bool refill = zone_level(target[zz]) != zone_level(power.scale[zz]);
+      power.scale[zz] = target[zz];
+      if (refill)
+        active[zz] = fill_zone(leds, zz, target[zz]);
+    }
+    power.current += idle[zz] + active[zz];
+  }
+}
+
+static void
+fill_intensity(
+  int start,
+  int count,
+  uint16_t level
+)
+{
+  uint16_t *dst = &intensity[start];
+  int ii;
+  for (ii=0; ii<count; ii++)
+    dst[ii] = level;
+
+  if (start == 0 && count == LED_COUNT)
+    intensity_flat = (level == 0xffff);
+  else if (count > 0 && level != 0xffff)
+    intensity_flat = false;
+}
+
+static inline uint16_t
+to_level(
+  double level
+)
+{
+  level = (level < 0) ? 0 : (level > 1.0) ? 1.0 : level;
+  return (uint16_t)(65535.0 * level + 0.5);
+}
+
+static int
+render_frame(
+  void
+)
+{
+  ws2811_led_t *leds = ledstring.channel[0].leds;
+
+  // brightness and the power limit are already in the pixels -- the driver only gets to
+  //   pass them through
+  fill_limited(leds);
+  ledstring.channel[0].brightness = 255;
+
+  if (spi_device) {
+    alarm_spi_encode(&spi, leds, 255);
+    if (alarm_spi_write(&spi))
+      return -1;
+    return 0;
+  }
 
   if (WS2811_SUCCESS != ws2811_render(&ledstring))
     return -1;
@@ -67,6 +479,366 @@ alarm_light_set_mono_rgbw(
   return 0;
 }
 
+static void
+output_fini(
+  void
+)
+{
+  if (spi_device)
+    alarm_spi_close(&spi);
+  else
+    ws2811_fini(&ledstring);
+}
+
+static void
+build_pipeline(
+  void
+)
+{
+  color_temp_t white;
+  white.kelvin = pipeline.white_kelvin;
+  interp_color_temp(&white);
+
+  // white LED expressed in red/green/blue channel units
+  double w_rgb[3] = {
+    pipeline.white_level * white.norm_red,
+    pipeline.white_level * white.norm_green,
+    pipeline.white_level * white.norm_blue,
+  };
+
+  int cc, vv;
+  for (cc=0; cc<3; cc++) {
+    for (vv=0; vv<256; vv++) {
+      double to   = (w_rgb[cc] > 0) ? vv / w_rgb[cc] : 255;
+      double from = vv * w_rgb[cc] + 0.5;
+      pipeline.to_w[cc][vv]   = (to   > 255) ? 255 : (uint8_t)to;
+      pipeline.from_w[cc][vv] = (from > 255) ? 255 : (uint8_t)from;
+    }
+  }
+
+  bool unity = true;
+  for (cc=0; cc<4; cc++) {
+    for (vv=0; vv<256; vv++)
+      pipeline.gain[cc][vv] = (uint8_t)(vv * pipeline.gain_val[cc] + 0.5);
+    if (pipeline.gain_val[cc] != 1.0)
+      unity = false;
+  }
+
+  // pick the fill kernels once here rather than testing flags per pixel
+  if (!(ledstring.channel[0].strip_type & SK6812_SHIFT_WMASK)) {
+    pipeline.kernel[0] = unity ? color_rgb       : color_rgb_gain;
+    pipeline.kernel[1] = unity ? color_rgb_dim   : color_rgb_gain_dim;
+    pipeline.kernel[2] = unity ? color_rgb_plane : color_rgb_gain_plane;
+  } else if (pipeline.extract) {
+    pipeline.kernel[0] = unity ? color_rgbw_extract       : color_rgbw_extract_gain;
+    pipeline.kernel[1] = unity ? color_rgbw_extract_dim   : color_rgbw_extract_gain_dim;
+    pipeline.kernel[2] = unity ? color_rgbw_extract_plane : color_rgbw_extract_gain_plane;
+  } else {
+    pipeline.kernel[0] = unity ? color_rgbw       : color_rgbw_gain;
+    pipeline.kernel[1] = unity ? color_rgbw_dim   : color_rgbw_gain_dim;
+    pipeline.kernel[2] = unity ? color_rgbw_plane : color_rgbw_gain_plane;
+  }
+}
+
+static const struct {
+  const char *name;
+  int strip_type;
+} strip_types[] = {
+  { "rgbw", SK6812_STRIP_RGBW },
+  { "rbgw", SK6812_STRIP_RBGW },
+  { "grbw", SK6812_STRIP_GRBW },
+  { "gbrw", SK6812_STRIP_GBRW },
+  { "brgw", SK6812_STRIP_BRGW },
+  { "bgrw", SK6812_STRIP_BGRW },
+  { "rgb",  WS2811_STRIP_RGB  },
+  { "rbg",  WS2811_STRIP_RBG  },
+  { "grb",  WS2811_STRIP_GRB  },
+  { "gbr",  WS2811_STRIP_GBR  },
+  { "brg",  WS2811_STRIP_BRG  },
+  { "bgr",  WS2811_STRIP_BGR  },
+};
+
+int
+alarm_light_set_spi(
+  const char *device,
+  int bits_per_bit
+)
+{
+  if (ledstring.channel[0].leds || (bits_per_bit != 3 && bits_per_bit != 4))
+    return -1;
+
+  spi_device = device ? device : ALARM_SPI_DEVICE;
+  spi_bits   = bits_per_bit;
+
+  return 0;
+}
+
+int
+alarm_light_set_strip(
+  const char *order
+)
+{
+  // the driver derives its channel shifts in ws2811_init, so this has to come first
+  if (!order || ledstring.channel[0].leds)
+    return -1;
+
+  unsigned ii;
+  for (ii=0; ii<sizeof(strip_types)/sizeof(strip_types[0]); ii++) {
+    if (0 == strcmp(order, strip_types[ii].name)) {
+      ledstring.channel[0].strip_type = strip_types[ii].strip_type;
+      return 0;
+    }
+  }
+
+  return -1;
+}
+
+int
+alarm_light_set_white_point(
+  double kelvin,
+  double level
+)
+{
+  // kelvin <= 0 turns extraction off
+  if (level < 0)
+    return -1;
+
+  pipeline.extract = (kelvin > 0) && (level > 0);
+  if (pipeline.extract) {
+    pipeline.white_kelvin = kelvin;
+    pipeline.white_level  = level;
+  }
+  build_pipeline();
+
+  return 0;
+}
+
+int
+alarm_light_set_channel_gain(
+  double red,
+  double green,
+  double blue,
+  double white
+)
+{
+  if (red < 0 || red > 1 || green < 0 || green > 1 ||
+      blue < 0 || blue > 1 || white < 0 || white > 1)
+    return -1;
+
+  pipeline.gain_val[0] = red;
+  pipeline.gain_val[1] = green;
+  pipeline.gain_val[2] = blue;
+  pipeline.gain_val[3] = white;
+  build_pipeline();
+
+  return 0;
+}
+
+int
+alarm_light_set_power_model(
+  double ma_red,
+  double ma_green,
+  double ma_blue,
+  double ma_white,
+  double ma_idle
+)
+{
+  if (ma_red < 0 || ma_green < 0 || ma_blue < 0 || ma_white < 0 || ma_idle < 0)
+    return -1;
+
+  power.ma_red   = ma_red;
+  power.ma_green = ma_green;
+  power.ma_blue  = ma_blue;
+  power.ma_white = ma_white;
+  power.ma_idle  = ma_idle;
+
+  return 0;
+}
+
+int
+alarm_light_set_power_budget(
+  double milliamps,
+  int zones
+)
+{
+  if (milliamps < 0 || zones < 1 || zones > MAX_ZONES || zones > LED_COUNT)
+    return -1;
+
+  power.budget = milliamps;
+  power.zones  = zones;
+
+  int zz;
+  for (zz=0; zz<MAX_ZONES; zz++) {
+    power.scale[zz]  = 1.0;
+    power.target[zz] = 1.0;
+  }
+
+  return 0;
+}
+
+double
+alarm_light_get_current(
+  void
+)
+{
+  return power.current;
+}
+
+int
+alarm_light_led_count(
+  void
+)
+{
+  return LED_COUNT;
+}
+
+int
+alarm_light_begin_frame(
+  void
+)
+{
+  if (in_frame)
+    return -1;
+  in_frame = true;
+
+  return 0;
+}
+
+int
+alarm_light_set_pixel(
+  int index,
+  double red,
+  double green,
+  double blue,
+  double white
+)
+{
+  if (!in_frame || !range_ok(index, 1))
+    return -1;
+  frame[index] = pack_rgbw(red, green, blue, white);
+
+  return 0;
+}
+
+int
+alarm_light_set_range(
+  int start,
+  int count,
+  double red,
+  double green,
+  double blue,
+  double white
+)
+{
+  if (!in_frame || !range_ok(start, count))
+    return -1;
+  fill_frame(start, count, pack_rgbw(red, green, blue, white));
+
+  return 0;
+}
+
+int
+alarm_light_copy_span(
+  int start,
+  int count,
+  const uint32_t *pixels
+)
+{
+  if (!in_frame || !range_ok(start, count) || !pixels)
+    return -1;
+  memcpy(&frame[start], pixels, count * sizeof(ws2811_led_t));
+
+  return 0;
+}
+
+int
+alarm_light_set_bright(
+  double bright
+)
+{
+  if (!in_frame)
+    return -1;
+  frame_level = to_level(bright);
+
+  return 0;
+}
+
+int
+alarm_light_set_intensity(
+  int index,
+  double level
+)
+{
+  if (!in_frame || !range_ok(index, 1))
+    return -1;
+  fill_intensity(index, 1, to_level(level));
+
+  return 0;
+}
+
+int
+alarm_light_set_intensity_range(
+  int start,
+  int count,
+  double level
+)
+{
+  if (!in_frame || !range_ok(start, count))
+    return -1;
+  fill_intensity(start, count, to_level(level));
+
+  return 0;
+}
+
+int
+alarm_light_copy_intensity_span(
+  int start,
+  int count,
+  const uint16_t *levels
+)
+{
+  if (!in_frame || !range_ok(start, count) || !levels)
+    return -1;
+  memcpy(&intensity[start], levels, count * sizeof(uint16_t));
+  if (count > 0)
+    intensity_flat = false;
+
+  return 0;
+}
+
+int
+alarm_light_commit_frame(
+  void
+)
+{
+  if (!in_frame)
+    return -1;
+  in_frame = false;
+
+  return render_frame();
+}
+
+int
+alarm_light_set_mono_rgbw(
+  double red,
+  double green,
+  double blue,
+  double white,
+  double bright
+)
+{
+  // whole-strip setters render immediately, so don't tear an open frame
+  if (in_frame)
+    return -1;
+
+  // synthesize colors & brightness
+  fill_frame(0, LED_COUNT, pack_rgbw(red, green, blue, white));
+  fill_intensity(0, LED_COUNT, 0xffff);
+  frame_level = to_level(bright);
+
+  return render_frame();
+}
+
 int
 alarm_light_set_mono_kelvin(
   double kelvin,
@@ -94,6 +866,9 @@ alarm_light_set_rand_kelvin(
   color.kelvin = kelvin;
   interp_color_temp(&color);
 
+  if (in_frame)
+    return -1;
+
   // synthesize colors & brightness
   uint32_t red, green, blue, c_white;
 
@@ -103,14 +878,12 @@ alarm_light_set_rand_kelvin(
     red     = (uint32_t)(255.0 * color.norm_red   * 0.5 * (1.0 + rand() / (double)RAND_MAX)) << 16;
     green   = (uint32_t)(255.0 * color.norm_green * 0.5 * (1.0 + rand() / (double)RAND_MAX)) <<  8;
     blue    = (uint32_t)(255.0 * color.norm_blue  * 0.5 * (1.0 + rand() / (double)RAND_MAX)) <<  0;
-    ledstring.channel[0].leds[ii] = c_white | red | green | blue;
+    frame[ii] = c_white | red | green | blue;
   }
-  ledstring.channel[0].brightness = (uint8_t)(255 * bright);
-
-  if (WS2811_SUCCESS != ws2811_render(&ledstring))
-    return -1;
+  fill_intensity(0, LED_COUNT, 0xffff);
+  frame_level = to_level(bright);
 
-  return 0;
+  return render_frame();
 }
 
 int
@@ -121,12 +894,12 @@ alarm_light_off(
   if (running) {
     running = false;
   } else {
-    int ii;
-    for (ii=0; ii<LED_COUNT; ii++)
-      ledstring.channel[0].leds[ii] = 0;
-    ledstring.channel[0].brightness = 0;
-    ws2811_render(&ledstring);
-    ws2811_fini(&ledstring);
+    in_frame = false;
+    fill_frame(0, LED_COUNT, 0);
+    fill_intensity(0, LED_COUNT, 0xffff);
+    frame_level = 0xffff;
+    render_frame();
+    output_fini();
   }
 
   return 0;
@@ -154,6 +927,123 @@ setup_handlers(
   sigaction(SIGTERM, &sa, NULL);
 }
 
+static void
+wakeup_state_at(
+    const wakeup_profile_t *profile,
+    double secSinceStart,
+    wakeup_state_t *out
+)
+{
+  // brightness
+  double d_maxBright = profile->bright_start + profile->bright_perSec * secSinceStart;
+  d_maxBright = (d_maxBright < 0) ? 0 : (d_maxBright > 2.0) ? 2.0 : d_maxBright;
+  if (d_maxBright >= 1.0) {
+    d_maxBright     = 1.0;
+    out->min_bright = pow(2, 8 * (1 - d_maxBright));
+    out->white      = pow(2, 8 * (d_maxBright - 2));
+  } else {
+    d_maxBright     = pow(2, 8 * (d_maxBright - 1));
+    out->min_bright = d_maxBright;
+    out->white      = 0;
+  }
+  out->max_bright = d_maxBright;
+
+  // color temp
+  out->kelvin = profile->kelvin_start + profile->kelvin_perSec * secSinceStart;
+}
+
+static void
+wakeup_codes(
+    const wakeup_state_t *state,
+    double codes[4]
+)
+{
+  // peak 8-bit output per channel: w, r, g, b
+  color_temp_t color;
+  color.kelvin = state->kelvin;
+  interp_color_temp(&color);
+
+  double scale = 255.0 * state->max_bright;
+  codes[0] = scale * state->white;
+  codes[1] = scale * color.norm_red;
+  codes[2] = scale * color.norm_green;
+  codes[3] = scale * color.norm_blue;
+}
+
+static double
+wakeup_fps(
+    const wakeup_profile_t *profile,
+    double secSinceStart,
+    const wakeup_state_t *state
+)
+{
+  // ramp: finite difference of the profile over one fastest frame
+  double h = 1.0 / fps_max;
+  wakeup_state_t ahead;
+  wakeup_state_at(profile, secSinceStart + h, &ahead);
+
+  double now_codes[4], ahead_codes[4];
+  wakeup_codes(state, now_codes);
+  wakeup_codes(&ahead, ahead_codes);
+
+  double peak = 0, rate = 0;
+  int cc;
+  for (cc=0; cc<4; cc++) {
+    double d = fabs(ahead_codes[cc] - now_codes[cc]) / h;
+    rate = (d > rate) ? d : rate;
+    peak = (now_codes[cc] > peak) ? now_codes[cc] : peak;
+  }
+
+  // flicker: only the min..max brightness swing moves from frame to frame
+  double swing = 0;
+  if (state->max_bright > 0)
+    swing = peak * (state->max_bright - state->min_bright) / state->max_bright;
+  double fps_swing = fps_min + (fps_max - fps_min) * ((swing > FLICKER_CODES) ? 1.0 : swing / FLICKER_CODES);
+
+  // grain: rand_kelvin spans half of each channel; needs a refresh once it is a code deep
+  double fps_grain = (0.5 * peak >= 1.0) ? GRAIN_FPS : fps_min;
+
+  // one code of ramp per frame, or whatever the flicker and grain ask for
+  double fps = rate;
+  fps = (fps_swing > fps) ? fps_swing : fps;
+  fps = (fps_grain > fps) ? fps_grain : fps;
+
+  return (fps < fps_min) ? fps_min : (fps > fps_max) ? fps_max : fps;
+}
+
+int
+alarm_light_set_sync(
+    int role,
+    const char *group,
+    int port
+)
+{
+  if (role != ALARM_LIGHT_SYNC_OFF && role != ALARM_LIGHT_SYNC_LEADER && role != ALARM_LIGHT_SYNC_FOLLOWER)
+    return -1;
+
+  sync_role  = role;
+  sync_group = group ? group : ALARM_SYNC_GROUP;
+  sync_port  = (port > 0) ? port : ALARM_SYNC_PORT;
+
+  return 0;
+}
+
+int
+alarm_light_set_fps_range(
+    double min_fps,
+    double max_fps
+)
+{
+  if (!isfinite(min_fps) || !isfinite(max_fps) ||
+      min_fps <= 0 || max_fps < min_fps || max_fps > ALARM_LIGHT_FPS_LIMIT)
+    return -1;
+
+  fps_min = min_fps;
+  fps_max = max_fps;
+
+  return 0;
+}
+
 int
 alarm_light_wakeup(
     double seconds,
@@ -200,65 +1090,223 @@ alarm_light_wakeup(
   close(STDOUT_FILENO);
   close(STDERR_FILENO);
 
-  // record startTime
-  struct timespec startTime, now;
+  // shared timeline -- a standalone node is simply a leader nobody listens to
+  alarm_sync_t sync;
+  if (sync_role == ALARM_LIGHT_SYNC_OFF) {
+    alarm_sync_open(&sync, true, NULL, 0);
+  } else if (alarm_sync_open(&sync, sync_role == ALARM_LIGHT_SYNC_LEADER, sync_group, sync_port)) {
+    // TODO: log error
+    exit(EXIT_FAILURE);
+  }
+
+  struct timespec startTime;
   clock_gettime(CLOCK_REALTIME, &startTime);
+  sync.timeline = (alarm_sync_timeline_t) {
+    .epoch_ns      = (int64_t)startTime.tv_sec * 1000000000 + startTime.tv_nsec,
+    .seed          = (uint32_t)time(0) ^ (uint32_t)getpid(),
+    .seconds       = seconds,
+    .bright_start  = bright_start,
+    .bright_perSec = bright_perSec,
+    .kelvin_start  = kelvin_start,
+    .kelvin_perSec = kelvin_perSec,
+    .fps_min       = fps_min,
+    .fps_max       = fps_max,
+  };
 
-  // seed rand()
-  srand(time(0));
+  wakeup_profile_t profile;
+  double nextFrame = 0;
+  uint32_t frameNum = 0;
+  sync.changed = sync.leader;
 
   setup_handlers();
 
   while (running) {
-    // elapsed time
-    clock_gettime(CLOCK_REALTIME, &now);
-    double d_secSinceStart = (now.tv_sec - startTime.tv_sec) + 1e-9 * (now.tv_nsec - startTime.tv_nsec);
+    // follower: (re)start from whatever the leader last published
+    if (sync.changed) {
+      sync.changed = false;
+      profile = (wakeup_profile_t) {
+        .seconds       = sync.timeline.seconds,
+        .bright_start  = sync.timeline.bright_start,
+        .bright_perSec = sync.timeline.bright_perSec,
+        .kelvin_start  = sync.timeline.kelvin_start,
+        .kelvin_perSec = sync.timeline.kelvin_perSec,
+      };
+      fps_min   = sync.timeline.fps_min;
+      fps_max   = sync.timeline.fps_max;
+      nextFrame = 0;
+      frameNum  = 0;
+    }
+    if (!sync.locked) {
+      alarm_sync_wait(&sync, 1.0);
+      continue;
+    }
+
+    // frame times are a pure function of the profile, so every node walks the same sequence
+    double d_secSinceStart = alarm_sync_now(&sync);
+    if (d_secSinceStart < nextFrame) {
+      alarm_sync_wait(&sync, nextFrame - d_secSinceStart);
+      continue;
+    }
 
     // expire after a while
-    if (d_secSinceStart > seconds)
+    if (nextFrame > profile.seconds)
       break;
 
-    // brightness
-    double d_maxBright = bright_start + bright_perSec * d_secSinceStart;
-    d_maxBright = (d_maxBright < 0) ? 0 : (d_maxBright > 2.0) ? 2.0 : d_maxBright;
-    double d_minBright;
-    double d_white;
-    if (d_maxBright >= 1.0) {
-      d_maxBright = 1.0;
-      d_minBright = pow(2, 8 * (1 - d_maxBright));
-      d_white     = pow(2, 8 * (d_maxBright - 2));
-    } else {
-      d_maxBright = pow(2, 8 * (d_maxBright - 1));
-      d_minBright = d_maxBright;
-      d_white     = 0;
+    // fell behind (or joined late) -- skip ahead to the newest frame that is due
+    wakeup_state_t state;
+    wakeup_state_at(&profile, nextFrame, &state);
+    double d_period = 1.0 / wakeup_fps(&profile, nextFrame, &state);
+    while (nextFrame + d_period <= d_secSinceStart && nextFrame <= profile.seconds) {
+      nextFrame += d_period;
+      frameNum++;
+      wakeup_state_at(&profile, nextFrame, &state);
+      d_period = 1.0 / wakeup_fps(&profile, nextFrame, &state);
     }
-    double bright = (d_minBright + ((d_maxBright - d_minBright) * (rand() / (double)RAND_MAX)));
 
-    // color temp
-    double kelvin = kelvin_start + kelvin_perSec * d_secSinceStart;
+    // reseed per frame so nodes agree on the flicker of frame N
+    srand(sync.timeline.seed + frameNum);
+    double bright = (state.min_bright + ((state.max_bright - state.min_bright) * (rand() / (double)RAND_MAX)));
 
-    alarm_light_set_rand_kelvin(kelvin, d_white, bright);
+    alarm_light_set_rand_kelvin(state.kelvin, state.white, bright);
+    alarm_sync_publish(&sync);
 
-    usleep(1000000 / FPS);
+    nextFrame += d_period;
+    frameNum++;
   }
+  alarm_sync_close(&sync);
 
   // turn off LEDs & get out
-  int ii;
-  for (ii=0; ii<LED_COUNT; ii++)
-    ledstring.channel[0].leds[ii] = 0;
-  ledstring.channel[0].brightness = 0;
-  ws2811_render(&ledstring);
-  ws2811_fini(&ledstring);
+  in_frame = false;
+  fill_frame(0, LED_COUNT, 0);
+  fill_intensity(0, LED_COUNT, 0xffff);
+  frame_level = 0xffff;
+  render_frame();
+  output_fini();
 
   exit(EXIT_SUCCESS);
 }
 
+static void
+audio_frame(
+    const alarm_audio_analyzer_t *an,
+    uint16_t *levels
+)
+{
+  // loudness -> brightness, spectral balance -> color temperature
+  double sum = 0, moment = 0, peak = 0;
+  int bb;
+  for (bb=0; bb<ALARM_AUDIO_BANDS; bb++) {
+    sum    += an->level[bb];
+    moment += an->level[bb] * bb;
+    peak    = (an->level[bb] > peak) ? an->level[bb] : peak;
+  }
+  double centroid = (sum > 0) ? moment / (sum * (ALARM_AUDIO_BANDS - 1)) : 0;
+
+  color_temp_t color;
+  color.kelvin = AUDIO_KELVIN_LOW + (AUDIO_KELVIN_HIGH - AUDIO_KELVIN_LOW) * centroid;
+  interp_color_temp(&color);
+
+  // bands laid out bass to treble along the strip, linearly interpolated between LEDs
+  int ii;
+  for (ii=0; ii<LED_COUNT; ii++) {
+    double pos  = (double)ii * (ALARM_AUDIO_BANDS - 1) / ((LED_COUNT > 1) ? LED_COUNT - 1 : 1);
+    int    b0   = (int)pos;
+    int    b1   = (b0 + 1 < ALARM_AUDIO_BANDS) ? b0 + 1 : b0;
+    double frac = pos - b0;
+    double lvl  = an->level[b0] + frac * (an->level[b1] - an->level[b0]);
+    levels[ii]  = (peak > 0) ? (uint16_t)(65535.0 * lvl / peak + 0.5) : 0;
+  }
+
+  alarm_light_begin_frame();
+  alarm_light_set_range(0, LED_COUNT, color.norm_red, color.norm_green, color.norm_blue, 0);
+  alarm_light_copy_intensity_span(0, LED_COUNT, levels);
+  alarm_light_set_bright(sum / ALARM_AUDIO_BANDS);
+  alarm_light_commit_frame();
+}
+
+int
+alarm_light_audio(
+    const char *path
+)
+{
+  // large and reused -- nothing is allocated once the stream is running
+  static alarm_audio_source_t   src;
+  static alarm_audio_analyzer_t an;
+  static float    hop[ALARM_AUDIO_HOP];
+  static uint16_t levels[LED_COUNT];
+
+  if (running || !path)
+    return -1;
+  if (alarm_audio_open(&src, path))
+    return -1;
+  alarm_audio_analyzer_init(&an, src.rate);
+
+  running = true;
+  setup_handlers();
+
+  struct timespec startTime, now;
+  clock_gettime(CLOCK_REALTIME, &startTime);
+  uint64_t samples = 0;
+  double nextFrame = 0;
+
+  while (running) {
+    int n = alarm_audio_read(&src, hop, ALARM_AUDIO_HOP);
+    if (n <= 0)
+      break;
+    if (n < ALARM_AUDIO_HOP)
+      memset(hop + n, 0, (ALARM_AUDIO_HOP - n) * sizeof(float));
+    alarm_audio_analyze(&an, hop);
+    samples += n;
+
+    // files and fast pipes are held to real time; a live device already is
+    double d_audioSec = samples / (double)src.rate;
+    clock_gettime(CLOCK_REALTIME, &now);
+    double d_ahead = d_audioSec - ((now.tv_sec - startTime.tv_sec) + 1e-9 * (now.tv_nsec - startTime.tv_nsec));
+    if (d_ahead > 0)
+      usleep((useconds_t)(1e6 * d_ahead));
+
+    if (d_audioSec < nextFrame)
+      continue;
+    nextFrame = d_audioSec + 1.0 / fps_max;
+
+    audio_frame(&an, levels);
+  }
+  running = false;
+  alarm_audio_close(&src);
+
+  // turn off LEDs & get out
+  in_frame = false;
+  fill_frame(0, LED_COUNT, 0);
+  fill_intensity(0, LED_COUNT, 0xffff);
+  frame_level = 0xffff;
+  render_frame();
+  output_fini();
+
+  return 0;
+}
+
 int
 alarm_light_init(
     void
 )
 {
+  build_pipeline();
+  fill_intensity(0, LED_COUNT, 0xffff);
+  frame_level = 0xffff;
+
   ws2811_return_t ret = 0;
+  if (spi_device) {
+    if (alarm_spi_setup(&spi, ledstring.channel[0].strip_type, LED_COUNT, spi_bits) ||
+        alarm_spi_open(&spi, spi_device)) {
+      alarm_spi_close(&spi);
+      ret = WS2811_ERROR_SPI_SETUP;
+      fprintf(stderr, "alarm_spi_open failed: %s\n", ws2811_get_return_t_str(ret));
+      return ret;
+    }
+    ledstring.channel[0].leds = spi_leds;
+    return ret;
+  }
+
   if (WS2811_SUCCESS != (ret = ws2811_init(&ledstring))) {
     fprintf(stderr, "ws2811_init failed: %s\n", ws2811_get_return_t_str(ret));
     return ret;
@@ -1,6 +1,8 @@
 #ifndef __ALARM_LIGHT_H__
 #define __ALARM_LIGHT_H__
 
+#include <stdint.h>
+
 extern int alarm_light_set_mono_rgbw(double red, double green, double blue, double white, double bright);
 extern int alarm_light_set_mono_kelvin(double kelvin, double white, double bright);
 extern int alarm_light_set_rand_kelvin(double kelvin, double white, double bright);
@@ -12,6 +14,53 @@ extern int alarm_light_wakeup(
     double kelvin_start,  // 1000
     double kelvin_perSec  //   50
 );
+#define ALARM_LIGHT_FPS_LIMIT     (120)
+extern int alarm_light_set_fps_range(double min_fps, double max_fps);
+
+// follow an audio stream until it ends: a 16-bit PCM WAV file, or raw S16_LE mono 44.1 kHz
+//   from a pipe or "-" for stdin (e.g. arecord from an ALSA loopback device)
+extern int alarm_light_audio(const char *path);
+
+// synchronized wakeup: a leader multicasts its timeline, followers render the same frames in
+//   lockstep and ignore their own wakeup arguments; group/port may be NULL/0 for the defaults
+#define ALARM_LIGHT_SYNC_OFF      (0)
+#define ALARM_LIGHT_SYNC_LEADER   (1)
+#define ALARM_LIGHT_SYNC_FOLLOWER (2)
+extern int alarm_light_set_sync(int role, const char *group, int port);
+
+// strip channel order as sent on the wire, e.g. "grbw" (default) or "grb"; call before init
+extern int alarm_light_set_strip(const char *order);
+
+// drive the strip from SPI MOSI instead of PWM/DMA, 3 or 4 SPI bits per data bit; NULL
+//   device means /dev/spidev0.0; call before init
+extern int alarm_light_set_spi(const char *device, int bits_per_bit);
 extern int alarm_light_init(void);
 
+// frame transactions: begin, any number of writes, then one render on commit
+//   pixels passed to alarm_light_copy_span are packed 0xWWRRGGBB
+//   per-LED intensity is fused with the strip brightness at 16 bits; spans are 0..0xffff
+//   color and level arguments are clamped to 0..1; brightness is full after init or off and
+//   otherwise holds whatever was set last
+extern int alarm_light_led_count(void);
+extern int alarm_light_begin_frame(void);
+extern int alarm_light_set_pixel(int index, double red, double green, double blue, double white);
+extern int alarm_light_set_range(int start, int count, double red, double green, double blue, double white);
+extern int alarm_light_copy_span(int start, int count, const uint32_t *pixels);
+extern int alarm_light_set_bright(double bright);
+extern int alarm_light_set_intensity(int index, double level);
+extern int alarm_light_set_intensity_range(int start, int count, double level);
+extern int alarm_light_copy_intensity_span(int start, int count, const uint16_t *levels);
+extern int alarm_light_commit_frame(void);
+
+// power limiting: model is mA per LED per channel at full scale plus idle draw per LED;
+//   budget is mA for the whole strip (0 disables), limited separately in 1..8 zones
+extern int alarm_light_set_power_model(double ma_red, double ma_green, double ma_blue, double ma_white, double ma_idle);
+extern int alarm_light_set_power_budget(double milliamps, int zones);
+extern double alarm_light_get_current(void);
+
+// color management: white point is the CCT of the white LED (kelvin <= 0 disables RGB->RGBW
+//   extraction) and its output relative to full RGB at that CCT; gains calibrate each channel
+extern int alarm_light_set_white_point(double kelvin, double level);
+extern int alarm_light_set_channel_gain(double red, double green, double blue, double white);
+
 #endif //__ALARM_LIGHT_H__
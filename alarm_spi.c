@@ -0,0 +1,150 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <linux/spi/spidev.h>
+
+#include "alarm_spi.h"
+
+// low time that latches the strip; SK6812 wants 80 us, newer WS2812B up to 280 us
+#define SPI_RESET_US    (300)
+
+int
+alarm_spi_setup(
+    alarm_spi_t *spi,
+    int strip_type,
+    int count,
+    int bits_per_bit
+)
+{
+  memset(spi, 0, sizeof(*spi));
+  spi->fd = -1;
+  spi->scale_bright = -1;
+
+  if ((bits_per_bit != 3 && bits_per_bit != 4) || count <= 0)
+    return -1;
+
+  spi->bits_per_bit = bits_per_bit;
+  spi->speed_hz     = WS2811_TARGET_FREQ * bits_per_bit;
+  spi->count        = count;
+
+  // same wire order the ws2811 driver derives from strip_type
+  spi->shift[0] = (strip_type >> 16) & 0xff;
+  spi->shift[1] = (strip_type >>  8) & 0xff;
+  spi->shift[2] = (strip_type >>  0) & 0xff;
+  spi->shift[3] = (strip_type >> 24) & 0xff;
+  spi->channels = (strip_type & SK6812_SHIFT_WMASK) ? 4 : 3;
+
+  // one table row per data byte, MSB first
+  int vv, bb;
+  for (vv=0; vv<256; vv++) {
+    uint32_t bits = 0;
+    for (bb=7; bb>=0; bb--) {
+      if (bits_per_bit == 3)
+        bits = (bits << 3) | (((vv >> bb) & 1) ? 0x6 : 0x4);
+      else
+        bits = (bits << 4) | (((vv >> bb) & 1) ? 0xe : 0x8);
+    }
+    for (bb=0; bb<bits_per_bit; bb++)
+      spi->encode[vv][bb] = bits >> (8 * (bits_per_bit - 1 - bb));
+  }
+
+  spi->data_len = (size_t)count * spi->channels * bits_per_bit;
+  spi->len      = spi->data_len + (size_t)SPI_RESET_US * spi->speed_hz / 8000000;
+  spi->buf      = calloc(spi->len, 1);
+  if (!spi->buf)
+    return -1;
+
+  return 0;
+}
+
+int
+alarm_spi_open(
+    alarm_spi_t *spi,
+    const char *device
+)
+{
+  int fd = open(device, O_RDWR);
+  if (fd < 0)
+    return -1;
+
+  uint8_t  mode  = SPI_MODE_0;
+  uint8_t  bits  = 8;
+  uint32_t speed = spi->speed_hz;
+  if (ioctl(fd, SPI_IOC_WR_MODE, &mode) < 0 ||
+      ioctl(fd, SPI_IOC_WR_BITS_PER_WORD, &bits) < 0 ||
+      ioctl(fd, SPI_IOC_WR_MAX_SPEED_HZ, &speed) < 0) {
+    close(fd);
+    return -1;
+  }
+
+  spi->fd = fd;
+  return 0;
+}
+
+void
+alarm_spi_close(
+    alarm_spi_t *spi
+)
+{
+  if (spi->fd >= 0)
+    close(spi->fd);
+  spi->fd = -1;
+
+  free(spi->buf);
+  spi->buf = NULL;
+}
+
+void
+alarm_spi_encode(
+    alarm_spi_t *spi,
+    const ws2811_led_t *leds,
+    uint8_t brightness
+)
+{
+  // match the ws2811 driver's (color * (brightness + 1)) >> 8
+  if (spi->scale_bright != brightness) {
+    int vv;
+    for (vv=0; vv<256; vv++)
+      spi->scale[vv] = (vv * (brightness + 1)) >> 8;
+    spi->scale_bright = brightness;
+  }
+
+  // the row width is fixed per strip, so each copy is a constant-size move
+  const int chans = spi->channels;
+  const int width = spi->bits_per_bit;
+  uint8_t *out = spi->buf;
+  int ii, cc;
+  for (ii=0; ii<spi->count; ii++) {
+    ws2811_led_t px = leds[ii];
+    for (cc=0; cc<chans; cc++) {
+      const uint8_t *row = spi->encode[spi->scale[(px >> spi->shift[cc]) & 0xff]];
+      if (width == 3)
+        memcpy(out, row, 3);
+      else
+        memcpy(out, row, 4);
+      out += width;
+    }
+  }
+}
+
+int
+alarm_spi_write(
+    alarm_spi_t *spi
+)
+{
+  struct spi_ioc_transfer xfer = {
+    .tx_buf        = (unsigned long)spi->buf,
+    .len           = spi->len,
+    .speed_hz      = spi->speed_hz,
+    .bits_per_word = 8,
+  };
+
+  if (ioctl(spi->fd, SPI_IOC_MESSAGE(1), &xfer) < 0)
+    return -1;
+
+  return 0;
+}
@@ -0,0 +1,61 @@
+#ifndef __ALARM_SPI_H__
+#define __ALARM_SPI_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ws2811.h"
+
+#define ALARM_SPI_DEVICE    "/dev/spidev0.0"
+
+// WS281x/SK6812 waveform on SPI MOSI: each data bit becomes 3 (110 / 100) or 4 (1110 / 1000)
+//   SPI bits, clocked at that multiple of the 800 kHz LED rate
+typedef struct alarm_spi {
+  int      fd;
+  int      bits_per_bit;       // 3 or 4
+  uint32_t speed_hz;
+  int      count;
+  int      channels;           // 3 for RGB strips, 4 with a white LED
+  uint8_t  shift[4];           // wire order, as shifts into a 0xWWRRGGBB pixel
+  uint8_t  encode[256][4];     // data byte -> its 3 or 4 SPI bytes
+  uint8_t  scale[256];         // brightness applied before encoding
+  int      scale_bright;       // brightness scale[] was built for, -1 if none
+  uint8_t *buf;                // encoded frame followed by the reset gap
+  size_t   data_len;
+  size_t   len;
+} alarm_spi_t;
+
+// set up the encoder and its output buffer; no device is touched
+extern int
+alarm_spi_setup(
+    alarm_spi_t *spi,
+    int strip_type,
+    int count,
+    int bits_per_bit
+);
+
+extern int
+alarm_spi_open(
+    alarm_spi_t *spi,
+    const char *device
+);
+
+extern void
+alarm_spi_close(
+    alarm_spi_t *spi
+);
+
+extern void
+alarm_spi_encode(
+    alarm_spi_t *spi,
+    const ws2811_led_t *leds,
+    uint8_t brightness
+);
+
+// one ioctl for the whole frame
+extern int
+alarm_spi_write(
+    alarm_spi_t *spi
+);
+
+#endif //__ALARM_SPI_H__
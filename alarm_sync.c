@@ -0,0 +1,326 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <time.h>
+#include <math.h>
+#include <endian.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "alarm_light.h"
+#include "alarm_sync.h"
+
+#define SYNC_MAGIC          (0x414c5359) // "ALSY"
+#define SYNC_VERSION        (1)
+#define SYNC_PACKET_LEN     (4 + 4 + 8 + 8 + 4 + 7 * 8)
+#define SYNC_PUBLISH_NS     (250000000)
+
+// follower offset: delay only ever makes a sample look early, so jump up to
+//   a later sample and only creep down to follow clock drift
+#define SYNC_OFFSET_RISE    (0.5)
+#define SYNC_OFFSET_FALL    (0.02)
+
+static int64_t
+realtime_ns(
+    void
+)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static uint8_t *
+put_u32(
+    uint8_t *p,
+    uint32_t v
+)
+{
+  v = htobe32(v);
+  memcpy(p, &v, sizeof(v));
+  return p + sizeof(v);
+}
+
+static uint8_t *
+put_u64(
+    uint8_t *p,
+    uint64_t v
+)
+{
+  v = htobe64(v);
+  memcpy(p, &v, sizeof(v));
+  return p + sizeof(v);
+}
+
+static uint8_t *
+put_double(
+    uint8_t *p,
+    double d
+)
+{
+  uint64_t v;
+  memcpy(&v, &d, sizeof(v));
+  return put_u64(p, v);
+}
+
+static const uint8_t *
+get_u32(
+    const uint8_t *p,
+    uint32_t *v
+)
+{
+  memcpy(v, p, sizeof(*v));
+  *v = be32toh(*v);
+  return p + sizeof(*v);
+}
+
+static const uint8_t *
+get_u64(
+    const uint8_t *p,
+    uint64_t *v
+)
+{
+  memcpy(v, p, sizeof(*v));
+  *v = be64toh(*v);
+  return p + sizeof(*v);
+}
+
+static const uint8_t *
+get_double(
+    const uint8_t *p,
+    double *d
+)
+{
+  uint64_t v;
+  p = get_u64(p, &v);
+  memcpy(d, &v, sizeof(v));
+  return p;
+}
+
+int
+alarm_sync_open(
+    alarm_sync_t *sync,
+    bool leader,
+    const char *group,
+    int port
+)
+{
+  memset(sync, 0, sizeof(*sync));
+  sync->fd     = -1;
+  sync->leader = leader;
+  sync->locked = leader;
+
+  // no group -- a standalone node that keeps its own timeline
+  if (!group)
+    return 0;
+
+  sync->group.sin_family = AF_INET;
+  sync->group.sin_port   = htons(port);
+  if (1 != inet_pton(AF_INET, group, &sync->group.sin_addr))
+    return -1;
+
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (fd < 0)
+    return -1;
+
+  if (leader) {
+    // stay on the local network, and loop back so nodes on this host hear it too
+    unsigned char ttl = 1, loop = 1;
+    setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+    setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+  } else {
+    // several followers may share one host
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    struct sockaddr_in any = {
+      .sin_family = AF_INET,
+      .sin_port   = htons(port),
+      .sin_addr   = { .s_addr = htonl(INADDR_ANY) },
+    };
+    struct ip_mreq mreq = {
+      .imr_multiaddr = sync->group.sin_addr,
+      .imr_interface = { .s_addr = htonl(INADDR_ANY) },
+    };
+    if (bind(fd, (struct sockaddr *)&any, sizeof(any)) < 0 ||
+        setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+      close(fd);
+      return -1;
+    }
+  }
+
+  sync->fd = fd;
+  return 0;
+}
+
+void
+alarm_sync_close(
+    alarm_sync_t *sync
+)
+{
+  if (sync->fd >= 0)
+    close(sync->fd);
+  sync->fd = -1;
+}
+
+int
+alarm_sync_publish(
+    alarm_sync_t *sync
+)
+{
+  if (!sync->leader || sync->fd < 0)
+    return 0;
+
+  int64_t now = realtime_ns();
+  if (now - sync->last_publish_ns < SYNC_PUBLISH_NS)
+    return 0;
+  sync->last_publish_ns = now;
+
+  const alarm_sync_timeline_t *tl = &sync->timeline;
+  uint8_t buf[SYNC_PACKET_LEN];
+  uint8_t *p = buf;
+  p = put_u32(p, SYNC_MAGIC);
+  p = put_u32(p, SYNC_VERSION);
+  p = put_u64(p, (uint64_t)now);
+  p = put_u64(p, (uint64_t)tl->epoch_ns);
+  p = put_u32(p, tl->seed);
+  p = put_double(p, tl->seconds);
+  p = put_double(p, tl->bright_start);
+  p = put_double(p, tl->bright_perSec);
+  p = put_double(p, tl->kelvin_start);
+  p = put_double(p, tl->kelvin_perSec);
+  p = put_double(p, tl->fps_min);
+  p = put_double(p, tl->fps_max);
+
+  if (sendto(sync->fd, buf, sizeof(buf), 0, (struct sockaddr *)&sync->group, sizeof(sync->group)) < 0)
+    return -1;
+
+  return 0;
+}
+
+static bool
+timeline_ok(
+    const alarm_sync_timeline_t *tl
+)
+{
+  // same limits alarm_light_set_fps_range applies, and a bounded run so catching up stays cheap
+  if (!isfinite(tl->seconds) || !isfinite(tl->bright_start) || !isfinite(tl->bright_perSec) ||
+      !isfinite(tl->kelvin_start) || !isfinite(tl->kelvin_perSec) ||
+      !isfinite(tl->fps_min) || !isfinite(tl->fps_max))
+    return false;
+  if (tl->fps_min <= 0 || tl->fps_max < tl->fps_min || tl->fps_max > ALARM_LIGHT_FPS_LIMIT)
+    return false;
+  if (tl->seconds < 0 || tl->seconds > ALARM_SYNC_MAX_SEC)
+    return false;
+
+  return true;
+}
+
+static bool
+timeline_equal(
+    const alarm_sync_timeline_t *a,
+    const alarm_sync_timeline_t *b
+)
+{
+  return a->epoch_ns      == b->epoch_ns      &&
+         a->seed          == b->seed          &&
+         a->seconds       == b->seconds       &&
+         a->bright_start  == b->bright_start  &&
+         a->bright_perSec == b->bright_perSec &&
+         a->kelvin_start  == b->kelvin_start  &&
+         a->kelvin_perSec == b->kelvin_perSec &&
+         a->fps_min       == b->fps_min       &&
+         a->fps_max       == b->fps_max;
+}
+
+static void
+absorb_packet(
+    alarm_sync_t *sync
+)
+{
+  uint8_t buf[SYNC_PACKET_LEN];
+  ssize_t len = recv(sync->fd, buf, sizeof(buf), MSG_DONTWAIT);
+  int64_t recv_ns = realtime_ns();
+  if (len != SYNC_PACKET_LEN)
+    return;
+
+  uint32_t magic, version;
+  uint64_t sent_ns, epoch_ns;
+  alarm_sync_timeline_t tl;
+  const uint8_t *p = buf;
+  p = get_u32(p, &magic);
+  p = get_u32(p, &version);
+  if (magic != SYNC_MAGIC || version != SYNC_VERSION)
+    return;
+  p = get_u64(p, &sent_ns);
+  p = get_u64(p, &epoch_ns);
+  tl.epoch_ns = (int64_t)epoch_ns;
+  p = get_u32(p, &tl.seed);
+  p = get_double(p, &tl.seconds);
+  p = get_double(p, &tl.bright_start);
+  p = get_double(p, &tl.bright_perSec);
+  p = get_double(p, &tl.kelvin_start);
+  p = get_double(p, &tl.kelvin_perSec);
+  p = get_double(p, &tl.fps_min);
+  p = get_double(p, &tl.fps_max);
+  if (!timeline_ok(&tl))
+    return;
+
+  double sample = 1e-9 * ((int64_t)sent_ns - recv_ns);
+  if (!sync->locked)
+    sync->offset = sample;
+  else if (sample > sync->offset)
+    sync->offset += SYNC_OFFSET_RISE * (sample - sync->offset);
+  else
+    sync->offset += SYNC_OFFSET_FALL * (sample - sync->offset);
+
+  if (!sync->locked || !timeline_equal(&tl, &sync->timeline))
+    sync->changed = true;
+  sync->timeline = tl;
+  sync->locked = true;
+}
+
+int
+alarm_sync_wait(
+    alarm_sync_t *sync,
+    double seconds
+)
+{
+  int64_t deadline = realtime_ns() + (int64_t)(1e9 * seconds);
+
+  // nothing to listen for -- a plain sleep that a signal can cut short
+  if (sync->leader || sync->fd < 0)
+    return poll(NULL, 0, (int)ceil(1e3 * seconds));
+
+  struct pollfd pfd = {
+    .fd     = sync->fd,
+    .events = POLLIN,
+  };
+  int64_t left;
+  while ((left = deadline - realtime_ns()) > 0) {
+    int ret = poll(&pfd, 1, (int)((left + 999999) / 1000000));
+    if (ret < 0)
+      return ret;
+    if (ret > 0)
+      absorb_packet(sync);
+
+    // a new timeline reschedules everything -- let the caller see it now
+    if (sync->changed)
+      return 1;
+  }
+
+  return 0;
+}
+
+double
+alarm_sync_now(
+    const alarm_sync_t *sync
+)
+{
+  return 1e-9 * (realtime_ns() - sync->timeline.epoch_ns) + sync->offset;
+}
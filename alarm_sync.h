@@ -0,0 +1,69 @@
+#ifndef __ALARM_SYNC_H__
+#define __ALARM_SYNC_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <netinet/in.h>
+
+#define ALARM_SYNC_GROUP    "239.255.42.99"
+#define ALARM_SYNC_PORT     (4299)
+#define ALARM_SYNC_MAX_SEC  (4 * 3600)
+
+// everything a follower needs to render the leader's frame N at the same instant
+typedef struct alarm_sync_timeline {
+  int64_t  epoch_ns;           // leader CLOCK_REALTIME at t = 0
+  uint32_t seed;               // rand() is reseeded with seed + frame number
+  double   seconds;
+  double   bright_start;
+  double   bright_perSec;
+  double   kelvin_start;
+  double   kelvin_perSec;
+  double   fps_min;
+  double   fps_max;
+} alarm_sync_timeline_t;
+
+typedef struct alarm_sync {
+  int      fd;
+  bool     leader;
+  struct sockaddr_in group;
+  bool     locked;             // follower has heard from a leader
+  bool     changed;            // timeline differs from the one last handed out
+  double   offset;             // leader clock minus local clock, seconds
+  int64_t  last_publish_ns;
+  alarm_sync_timeline_t timeline;
+} alarm_sync_t;
+
+extern int
+alarm_sync_open(
+    alarm_sync_t *sync,
+    bool leader,
+    const char *group,
+    int port
+);
+
+extern void
+alarm_sync_close(
+    alarm_sync_t *sync
+);
+
+// leader: send the timeline, at most a few times a second
+extern int
+alarm_sync_publish(
+    alarm_sync_t *sync
+);
+
+// sleep up to seconds; a follower absorbs leader packets meanwhile and returns early (1)
+//   when the timeline changes
+extern int
+alarm_sync_wait(
+    alarm_sync_t *sync,
+    double seconds
+);
+
+// seconds since the timeline epoch, on the leader's clock
+extern double
+alarm_sync_now(
+    const alarm_sync_t *sync
+);
+
+#endif //__ALARM_SYNC_H__
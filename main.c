@@ -45,6 +45,12 @@ struct options {
   double green;
   double blue;
   double white;
+  double budget;
+  double whitepoint;
+  char  *strip;
+  int    sync;
+  char  *audio;
+  char  *spi;
   bool   off;
 };
 
@@ -61,6 +67,12 @@ parse_args(
     .green  = -1,
     .blue   = -1,
     .white  = -1,
+    .budget = 0,
+    .whitepoint = 0,
+    .strip  = NULL,
+    .sync   = ALARM_LIGHT_SYNC_OFF,
+    .audio  = NULL,
+    .spi    = NULL,
     .off    = false
   };
 
@@ -76,12 +88,19 @@ parse_args(
       {"green",  required_argument, 0,         'g'},
       {"blue",   required_argument, 0,         'b'},
       {"white",  required_argument, 0,         'w'},
+      {"budget", required_argument, 0,         'p'},
+      {"whitepoint", required_argument, 0,     'W'},
+      {"strip",  required_argument, 0,         's'},
+      {"leader",   no_argument,       0,       'L'},
+      {"follower", no_argument,       0,       'F'},
+      {"audio",  required_argument, 0,         'A'},
+      {"spi",    required_argument, 0,         'S'},
       {0, 0, 0, 0}
     };
 
     int option_index = 0;
 
-    c = getopt_long(argc, argv, "B:k:a:r:g:b:w:o", long_options, &option_index);
+    c = getopt_long(argc, argv, "B:k:a:r:g:b:w:p:W:s:LFA:S:o", long_options, &option_index);
 
     if (-1 == c)
       break;
@@ -161,6 +180,29 @@ parse_args(
           print_usage();
         opts.white = strtod(optarg, 0);
         break;
+      case 'p':
+        opts.budget = strtod(optarg, 0);
+        break;
+      case 'W':
+        opts.whitepoint = strtod(optarg, 0);
+        break;
+      case 's':
+        opts.strip = optarg;
+        break;
+      case 'L':
+        opts.sync = ALARM_LIGHT_SYNC_LEADER;
+        break;
+      case 'F':
+        opts.sync = ALARM_LIGHT_SYNC_FOLLOWER;
+        break;
+      case 'A':
+        if (opts.off)
+          print_usage();
+        opts.audio = optarg;
+        break;
+      case 'S':
+        opts.spi = optarg;
+        break;
       case '?':
         break;
       default:
@@ -184,8 +226,25 @@ main(
   //printf("green : %f\n", opts.green );
   //printf("blue  : %f\n", opts.blue  );
   //printf("white : %f\n", opts.white );
+  //printf("budget: %f\n", opts.budget);
+  //printf("whitepoint: %f\n", opts.whitepoint);
+  //printf("strip : %s\n", opts.strip ? opts.strip : "grbw");
+  //printf("sync  : %d\n", opts.sync);
+  //printf("audio : %s\n", opts.audio ? opts.audio : "(none)");
+  //printf("spi   : %s\n", opts.spi ? opts.spi : "(pwm)");
   //printf("off   : %s\n", opts.off   ? "true" : "false");
 
+  if (opts.strip && alarm_light_set_strip(opts.strip)) {
+    fprintf(stderr, "Unknown strip order '%s'.\n", opts.strip);
+    return -1;
+  }
+  if (opts.spi)
+    alarm_light_set_spi(opts.spi, 3);
+  if (opts.budget > 0)
+    alarm_light_set_power_budget(opts.budget, 1);
+  if (opts.whitepoint > 0)
+    alarm_light_set_white_point(opts.whitepoint, 1.0);
+
   if (opts.off) {
     //printf("alarm_light_init()\n");
     alarm_light_init();
@@ -244,7 +303,20 @@ main(
     return 0;
   }
 
+  if (opts.audio) {
+    setup_handlers();
+    //printf("alarm_light_init()\n");
+    alarm_light_init();
+    //printf("alarm_light_audio(%s)\n", opts.audio);
+    if (alarm_light_audio(opts.audio)) {
+      fprintf(stderr, "Cannot play audio from '%s'.\n", opts.audio);
+      return -1;
+    }
+    return 0;
+  }
+
   setup_handlers();
+  alarm_light_set_sync(opts.sync, NULL, 0);
   //printf("alarm_light_init()\n");
   alarm_light_init();
   //printf("alarm_light_wakeup(600, 0, 0.004, 1000, 50)\n");
@@ -0,0 +1,80 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "../alarm_spi.h"
+
+// times alarm_spi_encode on a full strip; brightness alternates so the scale table rebuild
+//   is part of the measurement
+
+#define BENCH_LEDS    (120)
+#define BENCH_FRAMES  (200000)
+
+static double
+now_sec(
+    void
+)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int
+main(
+    void
+)
+{
+  static const struct {
+    const char *name;
+    int         strip_type;
+    int         bits_per_bit;
+  } runs[] = {
+    { "GRBW/3-bit", SK6812_STRIP_GRBW, 3 },
+    { "GRBW/4-bit", SK6812_STRIP_GRBW, 4 },
+    { "RGB/3-bit",  WS2811_STRIP_RGB,  3 },
+    { "RGB/4-bit",  WS2811_STRIP_RGB,  4 },
+  };
+  static ws2811_led_t leds[BENCH_LEDS];
+  int rr, ii;
+
+  srand(1);
+  for (ii=0; ii<BENCH_LEDS; ii++)
+    leds[ii] = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+
+  for (rr=0; rr<(int)(sizeof(runs) / sizeof(runs[0])); rr++) {
+    alarm_spi_t spi;
+    if (alarm_spi_setup(&spi, runs[rr].strip_type, BENCH_LEDS, runs[rr].bits_per_bit)) {
+      fprintf(stderr, "%s: setup failed\n", runs[rr].name);
+      return 1;
+    }
+
+    double fixed, varied, start;
+    uint32_t sum = 0;
+
+    // untimed pass to fault in the buffer and warm the tables
+    for (ii=0; ii<BENCH_FRAMES / 10; ii++)
+      alarm_spi_encode(&spi, leds, 255);
+
+    start = now_sec();
+    for (ii=0; ii<BENCH_FRAMES; ii++) {
+      alarm_spi_encode(&spi, leds, 255);
+      sum += spi.buf[ii % spi.data_len];
+    }
+    fixed = now_sec() - start;
+
+    start = now_sec();
+    for (ii=0; ii<BENCH_FRAMES; ii++) {
+      alarm_spi_encode(&spi, leds, ii & 0xff);
+      sum += spi.buf[ii % spi.data_len];
+    }
+    varied = now_sec() - start;
+
+    printf("%-11s %d LEDs: %6.2f us/frame, %6.2f us/frame with brightness changing (%08x)\n",
+           runs[rr].name, BENCH_LEDS, 1e6 * fixed / BENCH_FRAMES, 1e6 * varied / BENCH_FRAMES, sum);
+    alarm_spi_close(&spi);
+  }
+
+  return 0;
+}
@@ -0,0 +1,93 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "../ws2811.h"
+#include "../color_temp.h"
+#include "stubs.h"
+
+// stand-ins for libws2811 and libcolor-temp so the library runs without hardware;
+//   set STUB_LOG to an absolute path to get one line per rendered frame
+
+static FILE *stub_log = NULL;
+ws2811_t    *stub_strip = NULL;
+
+ws2811_return_t
+ws2811_init(
+    ws2811_t *ws2811
+)
+{
+  int cc;
+  for (cc=0; cc<RPI_PWM_CHANNELS; cc++)
+    ws2811->channel[cc].leds = calloc(ws2811->channel[cc].count + 1, sizeof(ws2811_led_t));
+  stub_strip = ws2811;
+
+  const char *path = getenv("STUB_LOG");
+  if (path)
+    stub_log = fopen(path, "w");
+
+  return WS2811_SUCCESS;
+}
+
+void
+ws2811_fini(
+    ws2811_t *ws2811
+)
+{
+  if (stub_log) {
+    fprintf(stub_log, "fini\n");
+    fclose(stub_log);
+    stub_log = NULL;
+  }
+}
+
+ws2811_return_t
+ws2811_render(
+    ws2811_t *ws2811
+)
+{
+  if (!stub_log)
+    return WS2811_SUCCESS;
+
+  // FNV-1a over the whole strip
+  uint32_t hash = 2166136261u;
+  int ii;
+  for (ii=0; ii<ws2811->channel[0].count; ii++) {
+    hash ^= ws2811->channel[0].leds[ii];
+    hash *= 16777619u;
+  }
+
+  struct timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  fprintf(stub_log, "%lld.%09ld %08x\n", (long long)now.tv_sec, now.tv_nsec, hash);
+  fflush(stub_log);
+
+  return WS2811_SUCCESS;
+}
+
+const char *
+ws2811_get_return_t_str(
+    const ws2811_return_t state
+)
+{
+  return (state == WS2811_SUCCESS) ? "Success" : "Failure";
+}
+
+int
+interp_color_temp(
+    color_temp_t *out
+)
+{
+  // rough blackbody shape, enough to move every channel
+  double k = (out->kelvin < 1000) ? 1000 : (out->kelvin > 20000) ? 20000 : out->kelvin;
+  out->norm_red   = (k < 6600) ? 1.0 : 6600 / k;
+  out->norm_green = (k < 6600) ? 0.3 + 0.7 * (k - 1000) / 5600 : 6600 / k;
+  out->norm_blue  = (k < 6600) ? (k - 1000) / 5600 : 1.0;
+  out->intensity  = 1.0;
+  out->byte_red   = (int)(255 * out->norm_red);
+  out->byte_green = (int)(255 * out->norm_green);
+  out->byte_blue  = (int)(255 * out->norm_blue);
+
+  return 0;
+}
@@ -0,0 +1,11 @@
+#ifndef __STUBS_H__
+#define __STUBS_H__
+
+#include <stdint.h>
+
+#include "../ws2811.h"
+
+// the strip handed to the last ws2811_init, so tests can read back what was rendered
+extern ws2811_t *stub_strip;
+
+#endif //__STUBS_H__
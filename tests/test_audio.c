@@ -0,0 +1,155 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+
+#include "../alarm_audio.h"
+
+// writes a stereo 16-bit WAV of back-to-back tones, streams it through alarm_audio_open /
+//   alarm_audio_analyze, and checks each tone lands in the band that holds its FFT bin
+
+#define RATE          (44100)
+#define TONE_SECONDS  (0.5)
+
+static const double tones_hz[] = { 100, 440, 1000, 3000, 6000 };
+#define TONE_COUNT    ((int)(sizeof(tones_hz) / sizeof(tones_hz[0])))
+
+static void
+put_le(
+    FILE *fp,
+    uint32_t v,
+    int bytes
+)
+{
+  int ii;
+  for (ii=0; ii<bytes; ii++)
+    fputc((v >> (8 * ii)) & 0xff, fp);
+}
+
+static int
+write_wav(
+    const char *path,
+    int frames_per_tone
+)
+{
+  FILE *fp = fopen(path, "wb");
+  if (!fp)
+    return -1;
+
+  uint32_t data_len = (uint32_t)frames_per_tone * TONE_COUNT * 2 * sizeof(int16_t);
+  fwrite("RIFF", 1, 4, fp);
+  put_le(fp, 36 + 8 + 4 + data_len, 4);
+  fwrite("WAVE", 1, 4, fp);
+
+  fwrite("fmt ", 1, 4, fp);
+  put_le(fp, 16, 4);
+  put_le(fp, 1, 2);                       // PCM
+  put_le(fp, 2, 2);                       // stereo
+  put_le(fp, RATE, 4);
+  put_le(fp, RATE * 2 * 2, 4);
+  put_le(fp, 2 * 2, 2);
+  put_le(fp, 16, 2);
+
+  // an odd-sized chunk the parser has to skip, pad byte included
+  fwrite("LIST", 1, 4, fp);
+  put_le(fp, 3, 4);
+  fwrite("abc\0", 1, 4, fp);
+
+  fwrite("data", 1, 4, fp);
+  put_le(fp, data_len, 4);
+  int tt, ii;
+  for (tt=0; tt<TONE_COUNT; tt++) {
+    for (ii=0; ii<frames_per_tone; ii++) {
+      int16_t v = (int16_t)(16000 * sin(2 * M_PI * tones_hz[tt] * ii / RATE));
+      put_le(fp, (uint16_t)v, 2);
+      put_le(fp, (uint16_t)v, 2);
+    }
+  }
+
+  fclose(fp);
+  return 0;
+}
+
+int
+main(
+    void
+)
+{
+  char path[] = "/tmp/alarm-audio-XXXXXX";
+  int fd = mkstemp(path);
+  if (fd < 0) {
+    perror("mkstemp");
+    return 1;
+  }
+  close(fd);
+
+  int frames_per_tone = (int)(TONE_SECONDS * RATE) / ALARM_AUDIO_HOP * ALARM_AUDIO_HOP;
+  if (write_wav(path, frames_per_tone)) {
+    perror("write_wav");
+    return 1;
+  }
+
+  static alarm_audio_source_t   src;
+  static alarm_audio_analyzer_t an;
+  static float hop[ALARM_AUDIO_HOP];
+  int failures = 0, bb, tt;
+
+  if (alarm_audio_open(&src, path) || src.rate != RATE || src.channels != 2) {
+    fprintf(stderr, "FAIL: could not open %s as 44.1 kHz stereo\n", path);
+    unlink(path);
+    return 1;
+  }
+  alarm_audio_analyzer_init(&an, src.rate);
+
+  // edges climb strictly and no bin is counted twice
+  for (bb=0; bb<ALARM_AUDIO_BANDS; bb++) {
+    if (an.band_hi[bb] <= an.band_lo[bb] || (bb > 0 && an.band_lo[bb] < an.band_hi[bb - 1])) {
+      fprintf(stderr, "FAIL: band %d is [%d,%d), band below ends at %d\n",
+              bb, an.band_lo[bb], an.band_hi[bb], (bb > 0) ? an.band_hi[bb - 1] : 0);
+      failures++;
+    }
+  }
+
+  for (tt=0; tt<TONE_COUNT; tt++) {
+    int hops;
+    for (hops=0; hops<frames_per_tone / ALARM_AUDIO_HOP; hops++) {
+      if (ALARM_AUDIO_HOP != alarm_audio_read(&src, hop, ALARM_AUDIO_HOP)) {
+        fprintf(stderr, "FAIL: short read in tone %d\n", tt);
+        failures++;
+        break;
+      }
+      alarm_audio_analyze(&an, hop);
+    }
+
+    int bin = (int)(tones_hz[tt] * ALARM_AUDIO_FFT_SIZE / RATE + 0.5);
+    int want = -1, loudest = 0;
+    for (bb=0; bb<ALARM_AUDIO_BANDS; bb++) {
+      if (bin >= an.band_lo[bb] && bin < an.band_hi[bb])
+        want = bb;
+      if (an.env[bb] > an.env[loudest])
+        loudest = bb;
+    }
+
+    if (want < 0 || loudest != want || an.level[want] < 0.9f) {
+      fprintf(stderr, "FAIL: %.0f Hz (bin %d) expected band %d at full level, loudest is band %d",
+              tones_hz[tt], bin, want, loudest);
+      for (bb=0; bb<ALARM_AUDIO_BANDS; bb++)
+        fprintf(stderr, " %.2f", an.level[bb]);
+      fprintf(stderr, "\n");
+      failures++;
+    }
+  }
+
+  alarm_audio_close(&src);
+  unlink(path);
+
+  if (failures) {
+    fprintf(stderr, "test_audio: %d failures\n", failures);
+    return 1;
+  }
+  printf("test_audio: %d tones in their bands\n", TONE_COUNT);
+
+  return 0;
+}
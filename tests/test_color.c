@@ -0,0 +1,95 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "../alarm_light.h"
+#include "../color_temp.h"
+#include "stubs.h"
+
+// RGB->RGBW extraction through the stub driver: neutral pixels at the white point's CCT move
+//   onto W, saturated ones keep W at 0; the stub's interp_color_temp is neutral at 6600 K
+
+static int failures = 0;
+
+static ws2811_led_t
+extract(
+    ws2811_led_t px
+)
+{
+  alarm_light_begin_frame();
+  alarm_light_copy_span(0, 1, &px);
+  alarm_light_commit_frame();
+  return stub_strip->channel[0].leds[0];
+}
+
+static void
+expect(
+    const char *what,
+    ws2811_led_t in,
+    ws2811_led_t got,
+    ws2811_led_t want
+)
+{
+  if (got != want) {
+    fprintf(stderr, "FAIL: %s: %08x -> %08x, expected %08x\n", what, in, got, want);
+    failures++;
+  }
+}
+
+int
+main(
+    void
+)
+{
+  alarm_light_init();
+  uint32_t vv;
+
+  // white LED matches full RGB at a neutral CCT: every gray is pure W
+  alarm_light_set_white_point(6600, 1.0);
+  for (vv=1; vv<256; vv++) {
+    ws2811_led_t px = (vv << 16) | (vv << 8) | vv;
+    expect("gray at the white point", px, extract(px), vv << 24);
+  }
+
+  // a white LED half as bright as full RGB takes twice the codes
+  alarm_light_set_white_point(6600, 0.5);
+  expect("gray on a half-level white LED", 0x00646464, extract(0x00646464), 0xc8000000);
+  expect("gray past the white LED's range", 0x00c8c8c8, extract(0x00c8c8c8), 0xff484848);
+
+  // a warm white point: the pixel's own color at that CCT goes to W, within the one-code
+  //   floor the tables round toward
+  alarm_light_set_white_point(4500, 1.0);
+  color_temp_t white = { .kelvin = 4500 };
+  interp_color_temp(&white);
+  for (vv=16; vv<256; vv++) {
+    uint32_t r = (uint32_t)(vv * white.norm_red   + 0.5);
+    uint32_t g = (uint32_t)(vv * white.norm_green + 0.5);
+    uint32_t b = (uint32_t)(vv * white.norm_blue  + 0.5);
+    ws2811_led_t px  = (r << 16) | (g << 8) | b;
+    ws2811_led_t out = extract(px);
+    uint32_t w = out >> 24;
+    if (w + 1 < vv || ((out >> 16) & 0xff) > 1 || ((out >> 8) & 0xff) > 1 || (out & 0xff) > 1) {
+      fprintf(stderr, "FAIL: white point color %u: %08x -> %08x\n", vv, px, out);
+      failures++;
+    }
+  }
+
+  // anything with a zero channel has no common component to move
+  static const ws2811_led_t saturated[] = {
+    0x00ff0000, 0x0000ff00, 0x000000ff, 0x00ff8000, 0x0000ffff, 0x00ff00ff, 0x0a800040,
+  };
+  for (vv=0; vv<sizeof(saturated)/sizeof(saturated[0]); vv++)
+    expect("saturated color", saturated[vv], extract(saturated[vv]), saturated[vv]);
+
+  // extraction off leaves gray on the RGB LEDs
+  alarm_light_set_white_point(0, 0);
+  expect("extraction disabled", 0x00808080, extract(0x00808080), 0x00808080);
+
+  if (failures) {
+    fprintf(stderr, "test_color: %d failures\n", failures);
+    return 1;
+  }
+  printf("test_color: extraction matched\n");
+
+  return 0;
+}
@@ -0,0 +1,145 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../alarm_light.h"
+#include "stubs.h"
+
+// drives the limiter through the stub driver with the default power model (12 mA per color
+//   channel, 18 mA white, 1 mA idle per LED); built with a short POWER_RELEASE_SEC so
+//   recovery takes a fraction of a second
+
+#define BUDGET_MA       (1000.0)
+#define BUDGET_SLACK    (0.02)
+#define RECOVER_SEC     (2.0)
+
+static int failures = 0;
+
+static void
+check(
+    int ok,
+    const char *what
+)
+{
+  if (!ok) {
+    fprintf(stderr, "FAIL: %s\n", what);
+    failures++;
+  }
+}
+
+static void
+render(
+    int start,
+    int count,
+    double level,
+    double bright
+)
+{
+  alarm_light_begin_frame();
+  alarm_light_set_range(0, alarm_light_led_count(), 0, 0, 0, 0);
+  alarm_light_set_range(start, count, level, level, level, level);
+  alarm_light_set_bright(bright);
+  alarm_light_commit_frame();
+}
+
+// one full-white LED over a one-code background: the full LED only comes out at 0xff once
+//   the limiter is within half a code of unity, the background goes black if it truncates
+static void
+render_recovery(
+    void
+)
+{
+  alarm_light_begin_frame();
+  alarm_light_set_range(0, alarm_light_led_count(), 1.5 / 255, 1.5 / 255, 1.5 / 255, 1.5 / 255);
+  alarm_light_set_pixel(0, 1.0, 1.0, 1.0, 1.0);
+  alarm_light_set_bright(1.0);
+  alarm_light_commit_frame();
+}
+
+static int
+near_budget(
+    void
+)
+{
+  double ma = alarm_light_get_current();
+  return ma <= BUDGET_MA * (1 + BUDGET_SLACK) && ma >= BUDGET_MA * (1 - BUDGET_SLACK);
+}
+
+int
+main(
+    void
+)
+{
+  alarm_light_init();
+  const int count = alarm_light_led_count();
+  const int half  = count / 2;
+  ws2811_led_t *leds = stub_strip->channel[0].leds;
+  ws2811_led_t *ref  = calloc(count, sizeof(ws2811_led_t));
+
+  // attack: the first frame over budget is already limited
+  alarm_light_set_power_budget(0, 1);
+  render(0, count, 1.0, 1.0);
+  check(leds[0] == 0xffffffff && alarm_light_get_current() > 6 * BUDGET_MA, "unlimited full white");
+  alarm_light_set_power_budget(BUDGET_MA, 1);
+  render(0, count, 1.0, 1.0);
+  check(near_budget(), "first over-budget frame is held to the budget");
+  check(leds[0] < 0x40404040 && leds[0] == leds[count - 1], "limited frame scaled evenly");
+
+  // recovery: one over-budget frame, then an under-budget scene must come back to exactly
+  //   the unlimited output and stay there
+  alarm_light_set_power_budget(0, 1);
+  render_recovery();
+  memcpy(ref, leds, count * sizeof(ws2811_led_t));
+  double ref_ma = alarm_light_get_current();
+  check(ref[0] == 0xffffffff && ref[1] == 0x01010101 && ref_ma < BUDGET_MA, "recovery scene");
+
+  alarm_light_set_power_budget(BUDGET_MA, 1);
+  render(0, count, 1.0, 1.0);
+  int frames, settled = -1;
+  for (frames=0; frames<RECOVER_SEC * 100 && settled < 0; frames++) {
+    usleep(10000);
+    render_recovery();
+    if (0 == memcmp(leds, ref, count * sizeof(ws2811_led_t)))
+      settled = frames;
+  }
+  check(settled >= 0, "limiter recovers to unity");
+  for (frames=0; frames<20; frames++) {
+    usleep(10000);
+    render_recovery();
+    if (memcmp(leds, ref, count * sizeof(ws2811_led_t)) || alarm_light_get_current() != ref_ma)
+      break;
+  }
+  check(frames == 20, "recovered output stays at unity");
+
+  // zones: a dark zone hands its whole share to the lit one
+  alarm_light_set_power_budget(BUDGET_MA, 2);
+  render(half, count - half, 1.0, 1.0);
+  check(near_budget(), "lit zone gets the dark zone's share");
+  check(leds[0] == 0 && leds[half] != 0, "dark zone stays dark");
+
+  // two equal zones split evenly
+  alarm_light_set_power_budget(BUDGET_MA, 2);
+  render(0, count, 1.0, 1.0);
+  check(near_budget() && leds[0] == leds[half], "equal zones split the budget evenly");
+
+  // a zone under its even share keeps full scale, the other gets the rest
+  alarm_light_set_power_budget(BUDGET_MA, 2);
+  alarm_light_begin_frame();
+  alarm_light_set_range(0, half, 0.1, 0.1, 0.1, 0.1);
+  alarm_light_set_range(half, count - half, 1.0, 1.0, 1.0, 1.0);
+  alarm_light_commit_frame();
+  check(leds[0] == 0x19191919, "zone under its share is untouched");
+  check(near_budget() && leds[half] > leds[0] && leds[half] < 0xffffffff,
+        "zone over its share gets the remainder");
+
+  free(ref);
+  if (failures) {
+    fprintf(stderr, "test_power: %d failures\n", failures);
+    return 1;
+  }
+  printf("test_power: recovered to unity after %d frames\n", settled + 1);
+
+  return 0;
+}
@@ -0,0 +1,94 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../alarm_spi.h"
+
+// encodes fixed pixels and compares the SPI bytes against hand-derived waveforms;
+//   3-bit cells are 100 / 110, 4-bit cells 1000 / 1110, MSB first, in wire order
+
+typedef struct spi_case {
+  const char   *name;
+  int           strip_type;
+  int           bits_per_bit;
+  uint8_t       brightness;
+  int           count;
+  ws2811_led_t  leds[2];
+  size_t        len;           // data plus reset gap
+  size_t        data_len;
+  uint8_t       expect[24];
+} spi_case_t;
+
+static const spi_case_t cases[] = {
+  { "GRBW/3-bit", SK6812_STRIP_GRBW, 3, 255, 2, { 0xff00a55a, 0x00000001 }, 114, 24, {
+      0xd3, 0x49, 0xa6,  0x92, 0x49, 0x24,  0x9a, 0x6d, 0x34,  0xdb, 0x6d, 0xb6,
+      0x92, 0x49, 0x24,  0x92, 0x49, 0x24,  0x92, 0x49, 0x26,  0x92, 0x49, 0x24 } },
+  { "GRBW/3-bit", SK6812_STRIP_GRBW, 3, 255, 1, { 0x01ff8000 }, 102, 12, {
+      0xd2, 0x49, 0x24,  0xdb, 0x6d, 0xb6,  0x92, 0x49, 0x24,  0x92, 0x49, 0x26 } },
+  { "RGB/4-bit", WS2811_STRIP_RGB, 4, 255, 1, { 0xff00a55a }, 132, 12, {
+      0x88, 0x88, 0x88, 0x88,  0xe8, 0xe8, 0x8e, 0x8e,  0x8e, 0x8e, 0xe8, 0xe8 } },
+  { "RGB/4-bit at 127", WS2811_STRIP_RGB, 4, 127, 1, { 0x00ff0000 }, 132, 12, {
+      0x8e, 0xee, 0xee, 0xee,  0x88, 0x88, 0x88, 0x88,  0x88, 0x88, 0x88, 0x88 } },
+};
+#define CASE_COUNT    ((int)(sizeof(cases) / sizeof(cases[0])))
+
+int
+main(
+    void
+)
+{
+  int failures = 0, cc;
+  size_t ii;
+
+  for (cc=0; cc<CASE_COUNT; cc++) {
+    const spi_case_t *tc = &cases[cc];
+    alarm_spi_t spi;
+
+    if (alarm_spi_setup(&spi, tc->strip_type, tc->count, tc->bits_per_bit)) {
+      fprintf(stderr, "FAIL: %s setup\n", tc->name);
+      failures++;
+      continue;
+    }
+    alarm_spi_encode(&spi, tc->leds, tc->brightness);
+
+    if (spi.len != tc->len || spi.data_len != tc->data_len) {
+      fprintf(stderr, "FAIL: %s is %zu bytes (%zu data), expected %zu (%zu)\n",
+              tc->name, spi.len, spi.data_len, tc->len, tc->data_len);
+      failures++;
+    } else if (memcmp(spi.buf, tc->expect, tc->data_len)) {
+      fprintf(stderr, "FAIL: %s encoded", tc->name);
+      for (ii=0; ii<tc->data_len; ii++)
+        fprintf(stderr, " %02x", spi.buf[ii]);
+      fprintf(stderr, "\n");
+      failures++;
+    } else {
+      // the reset gap must hold the line low
+      for (ii=tc->data_len; ii<spi.len; ii++) {
+        if (spi.buf[ii]) {
+          fprintf(stderr, "FAIL: %s reset gap byte %zu is %02x\n", tc->name, ii, spi.buf[ii]);
+          failures++;
+          break;
+        }
+      }
+    }
+
+    alarm_spi_close(&spi);
+  }
+
+  // only 3 and 4 SPI bits per data bit are supported
+  alarm_spi_t bad;
+  if (0 == alarm_spi_setup(&bad, WS2811_STRIP_RGB, 1, 5)) {
+    fprintf(stderr, "FAIL: 5 bits per bit accepted\n");
+    failures++;
+  }
+  alarm_spi_close(&bad);
+
+  if (failures) {
+    fprintf(stderr, "test_spi: %d failures\n", failures);
+    return 1;
+  }
+  printf("test_spi: %d encodings matched\n", CASE_COUNT);
+
+  return 0;
+}
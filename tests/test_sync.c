@@ -0,0 +1,150 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "../alarm_light.h"
+
+// a leader and a follower on loopback, each rendering through the stub driver; every frame
+//   is a hash of the whole strip, which only matches if frame number and seed match
+
+#define RUN_SECONDS   (3)
+#define MAX_FRAMES    (4096)
+#define MAX_SKEW_SEC  (0.005)
+
+typedef struct frame_log {
+  int      count;
+  bool     done;
+  double   when[MAX_FRAMES];
+  uint32_t hash[MAX_FRAMES];
+} frame_log_t;
+
+static void
+start_node(
+    int role,
+    int port,
+    const char *log_path
+)
+{
+  pid_t pid = fork();
+  if (pid < 0)
+    exit(EXIT_FAILURE);
+  if (pid > 0) {
+    // alarm_light_wakeup daemonizes, so this child returns almost at once
+    waitpid(pid, NULL, 0);
+    return;
+  }
+
+  setenv("STUB_LOG", log_path, 1);
+  alarm_light_set_sync(role, NULL, port);
+  alarm_light_init();
+  alarm_light_wakeup(RUN_SECONDS, 0.6, 0.1, 2000, 100);
+  exit(EXIT_FAILURE);
+}
+
+static void
+read_log(
+    const char *path,
+    frame_log_t *log
+)
+{
+  memset(log, 0, sizeof(*log));
+  FILE *fp = fopen(path, "r");
+  if (!fp)
+    return;
+
+  char line[128];
+  while (fgets(line, sizeof(line), fp)) {
+    if (0 == strncmp(line, "fini", 4)) {
+      log->done = true;
+      break;
+    }
+    if (log->count < MAX_FRAMES &&
+        2 == sscanf(line, "%lf %x", &log->when[log->count], &log->hash[log->count]))
+      log->count++;
+  }
+  fclose(fp);
+}
+
+int
+main(
+    void
+)
+{
+  char dir[] = "/tmp/alarm-sync-XXXXXX";
+  if (!mkdtemp(dir)) {
+    perror("mkdtemp");
+    return 1;
+  }
+  char leader_path[64], follower_path[64];
+  snprintf(leader_path,   sizeof(leader_path),   "%s/leader.log",   dir);
+  snprintf(follower_path, sizeof(follower_path), "%s/follower.log", dir);
+  int port = 20000 + getpid() % 20000;
+
+  // follower first, so it hears the leader's very first packet
+  start_node(ALARM_LIGHT_SYNC_FOLLOWER, port, follower_path);
+  usleep(300000);
+  start_node(ALARM_LIGHT_SYNC_LEADER, port, leader_path);
+
+  static frame_log_t leader, follower;
+  int waited;
+  for (waited=0; waited<(RUN_SECONDS + 5) * 10; waited++) {
+    usleep(100000);
+    read_log(leader_path, &leader);
+    read_log(follower_path, &follower);
+    if (leader.done && follower.done)
+      break;
+  }
+  unlink(leader_path);
+  unlink(follower_path);
+  rmdir(dir);
+
+  if (!leader.done || !follower.done) {
+    fprintf(stderr, "FAIL: nodes did not finish (leader %d frames, follower %d frames)\n",
+            leader.count, follower.count);
+    return 1;
+  }
+
+  // find the follower's first frame in the leader's sequence, then both must match frame
+  //   for frame to the end -- the last one is the blank frame on the way out
+  int first = -1, ii;
+  for (ii=0; ii<leader.count - 1 && first < 0; ii++)
+    if (leader.hash[ii] == follower.hash[0])
+      first = ii;
+  if (first < 0 || follower.count < 10) {
+    fprintf(stderr, "FAIL: follower never locked onto the leader's frames\n");
+    return 1;
+  }
+
+  int failures = 0;
+  if (leader.count - first != follower.count) {
+    fprintf(stderr, "FAIL: leader rendered %d frames after lock, follower %d\n",
+            leader.count - first, follower.count);
+    failures++;
+  }
+  int matched = 0;
+  for (ii=0; ii<follower.count - 1 && first + ii < leader.count - 1; ii++) {
+    double skew = follower.when[ii] - leader.when[first + ii];
+    if (follower.hash[ii] != leader.hash[first + ii]) {
+      fprintf(stderr, "FAIL: frame %d differs (%08x vs %08x)\n",
+              first + ii, leader.hash[first + ii], follower.hash[ii]);
+      failures++;
+    } else if (skew > MAX_SKEW_SEC || skew < -MAX_SKEW_SEC) {
+      fprintf(stderr, "FAIL: frame %d rendered %.1f ms apart\n", first + ii, 1e3 * skew);
+      failures++;
+    } else {
+      matched++;
+    }
+  }
+
+  if (failures) {
+    fprintf(stderr, "test_sync: %d failures\n", failures);
+    return 1;
+  }
+  printf("test_sync: %d frames matched from leader frame %d\n", matched, first);
+
+  return 0;
+}